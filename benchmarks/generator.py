@@ -0,0 +1,18 @@
+def numbers(n):
+    for i in range(n):
+        yield i
+
+def evens(it):
+    for x in it:
+        if x % 2 == 0:
+            yield x
+
+def squares(it):
+    for x in it:
+        yield x * x
+
+total = 0
+for x in squares(evens(numbers(3000000))):
+    total += x
+
+assert total == 4499995500001000000
@@ -0,0 +1,9 @@
+def spawn(x, y=0, team=None, hp=100):
+    return x + y + hp
+
+total = 0
+for i in range(2000000):
+    total += spawn(i, y=1, team='red')
+    total += spawn(i)
+
+assert total == 2000000 * 1999999 + 2000000 * 201
@@ -0,0 +1,12 @@
+d = {str(i): i for i in range(100)}
+keys = [str(i) for i in range(120)]
+
+total = 0
+for _ in range(20000):
+    for k in keys:
+        try:
+            total += d[k]
+        except KeyError:
+            total -= 1
+
+assert total == 20000 * (4950 - 20)
@@ -35,11 +35,54 @@
 #define PK_ENABLE_MIMALLOC          0                
 #endif
 
+// Use threaded code (labels as values) for the main interpreter loop
+#ifndef PK_ENABLE_COMPUTED_GOTO     // can be overridden by cmake
+    #if defined(__GNUC__) || defined(__clang__)
+        #define PK_ENABLE_COMPUTED_GOTO 1
+    #else
+        #define PK_ENABLE_COMPUTED_GOTO 0
+    #endif
+#endif
+
+#if PK_ENABLE_COMPUTED_GOTO && defined(_MSC_VER) && !defined(__clang__)
+    #undef PK_ENABLE_COMPUTED_GOTO
+    #define PK_ENABLE_COMPUTED_GOTO 0
+#endif
+
+// Number of loop back-edges and calls between two clock reads of the watchdog
+#ifndef PK_WATCHDOG_POLL_INTERVAL   // can be overridden by cmake
+    #define PK_WATCHDOG_POLL_INTERVAL 64
+#endif
+
 // GC min threshold
 #ifndef PK_GC_MIN_THRESHOLD         // can be overridden by cmake
     #define PK_GC_MIN_THRESHOLD     20000
 #endif
 
+// Full collections with `gc.set_threads()` use the workers when there are this many arenas
+#ifndef PK_GC_PARALLEL_MIN_ARENAS   // can be overridden by cmake
+    #define PK_GC_PARALLEL_MIN_ARENAS 16
+#endif
+
+// Size classes of the arenas of small objects, steps of `PK_POOL_SIZE_STEP` bytes up to
+// `PK_POOL_FINE_MAX_SIZE`, then 4 sizes per doubling up to `PK_POOL_MAX_SIZE`
+#ifndef PK_POOL_SIZE_STEP           // can be overridden by cmake
+    #define PK_POOL_SIZE_STEP       16
+#endif
+
+#ifndef PK_POOL_FINE_MAX_SIZE       // can be overridden by cmake
+    #define PK_POOL_FINE_MAX_SIZE   512
+#endif
+
+#ifndef PK_POOL_MAX_SIZE            // can be overridden by cmake
+    #define PK_POOL_MAX_SIZE        2048
+#endif
+
+// Freed objects above `PK_POOL_MAX_SIZE` and up to this size are kept for reuse (off by default)
+#ifndef PK_LARGE_POOL_MAX_SIZE      // can be overridden by cmake
+    #define PK_LARGE_POOL_MAX_SIZE  0
+#endif
+
 // This is the maximum size of the value stack in py_TValue units
 // The actual size in bytes equals `sizeof(py_TValue) * PK_VM_STACK_SIZE`
 #ifndef PK_VM_STACK_SIZE            // can be overridden by cmake
@@ -62,6 +105,12 @@
 // For class itself
 #define PK_TYPE_ATTR_LOAD_FACTOR    0.5f
 
+// Class instances share the layout of their attributes through shapes (hidden classes)
+// An instance falls back to a hash table beyond this number of attributes
+#define PK_INST_SHAPE_MAX_KEYS      32
+// or when its type already has this number of shapes
+#define PK_INST_SHAPE_MAX_COUNT     1024
+
 #ifdef _WIN32
     #define PK_PLATFORM_SEP '\\'
 #else
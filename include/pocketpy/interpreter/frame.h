@@ -5,7 +5,6 @@
 #include "pocketpy/pocketpy.h"
 
 void FastLocals__to_dict(py_TValue* locals, const CodeObject* co) PY_RETURN;
-NameDict* FastLocals__to_namedict(py_TValue* locals, const CodeObject* co);
 
 typedef struct ValueStack {
     py_TValue* sp;
@@ -14,12 +13,6 @@ typedef struct ValueStack {
     py_TValue begin[PK_VM_STACK_SIZE + PK_MAX_CO_VARNAMES];
 } ValueStack;
 
-typedef struct FrameExcInfo {
-    int iblock;     // try block index
-    int offset;     // stack offset from p0
-    py_TValue exc;  // handled exception
-} FrameExcInfo;
-
 typedef struct py_Frame {
     struct py_Frame* f_back;
     const CodeObject* co;
@@ -28,8 +21,8 @@ typedef struct py_Frame {
     py_Ref globals;  // a module object or a dict object
     py_Ref locals;
     bool is_locals_special;
+    bool is_ctor;  // an `__init__` frame, the new instance is stored right below `p0`
     int ip;
-    c11_vector /*T=FrameExcInfo*/ exc_stack;
 } py_Frame;
 
 typedef struct SourceLocation {
@@ -52,12 +45,12 @@ int Frame__getglobal(py_Frame* self, py_Name name) PY_RAISE PY_RETURN;
 bool Frame__setglobal(py_Frame* self, py_Name name, py_TValue* val) PY_RAISE;
 int Frame__delglobal(py_Frame* self, py_Name name) PY_RAISE;
 
-py_Ref Frame__getclosure(py_Frame* self, py_Name name);
 py_StackRef Frame__getlocal_noproxy(py_Frame* self, py_Name name);
 
+py_StackRef Frame__stack_base(py_Frame* self);
+const CodeHandler* Frame__find_handler(py_Frame* self);
 int Frame__goto_exception_handler(py_Frame* self, ValueStack*, py_Ref);
-void Frame__begin_try(py_Frame* self, py_TValue* sp);
-FrameExcInfo* Frame__top_exc_info(py_Frame* self);
+py_Ref Frame__handled_exc(py_Frame* self);
 
 void Frame__gc_mark(py_Frame* self, c11_vector* p_stack);
 SourceLocation Frame__source_location(py_Frame* self);
\ No newline at end of file
@@ -6,8 +6,20 @@
 typedef struct Generator{
     py_Frame* frame;
     int state;
+    // values of [frame->p0, sp) while suspended, reused across steps
+    py_TValue* backup;
+    int backup_length;
+    int backup_capacity;
 } Generator;
 
 void pk_newgenerator(py_Ref out, py_Frame* frame, py_TValue* begin, py_TValue* end);
 
-void Generator__dtor(Generator* ud);
\ No newline at end of file
+void Generator__dtor(Generator* ud);
+
+typedef struct Task {
+    py_Frame* frame;  // base frame of the suspended frames, linked to callees by `f_back`
+    py_StackRef p0;   // p0 of the base frame when suspended
+    int state;        // 0: not started, 1: suspended, 2: finished, 3: running
+} Task;
+
+void Task__dtor(Task* ud);
@@ -2,19 +2,44 @@
 
 #include "pocketpy/objects/object.h"
 #include "pocketpy/interpreter/objectpool.h"
+#include "pocketpy/common/threads.h"
 #include <time.h>
 
+typedef enum ManagedHeapPhase {
+    ManagedHeapPhase_IDLE,
+    ManagedHeapPhase_MARK,   // `gc_roots` holds the gray objects of an incremental cycle
+    ManagedHeapPhase_SWEEP,  // arenas and large objects are swept a few at a time, or on demand
+} ManagedHeapPhase;
+
 typedef struct ManagedHeap {
     MultiPool small_objects;
     c11_vector /* PyObject_p */ large_objects;
+    LargePool large_pool;  // memory of `large_objects`
     c11_vector /* PyObject_p */ gc_roots;
-    size_t large_total_size;
+    c11_vector /* PyObject_p */ remembered;  // old objects that may point to young ones
+    c11_vector /* PyObject_p */ old_marked;  // old objects marked by a minor gc
+    c11_vector /* PyObject_p */ gray_again;  // written during an incremental mark
+    int large_young_begin;  // `large_objects[large_young_begin:]` are young
+
+    ManagedHeapPhase gc_phase;
+    int gc_cycle_freed;     // objects found dead by the cycle and not reported yet
+    int gc_cycle_marked;    // objects marked by the cycle so far
+    int large_sweep_index;  // `large_objects[large_sweep_index:large_sweep_end]` are not swept
+    int large_sweep_end;
+    int large_sweep_live;  // `large_objects[:large_sweep_live]` are swept survivors
 
     int freed_ma[3];
-    int gc_threshold;  // threshold for gc_counter
-    int gc_counter;    // objects created since last gc
+    int gc_threshold;      // threshold for gc_counter
+    int gc_counter;        // objects created since last gc
+    int gc_young_count;    // young objects, approximately
+    int gc_old_threshold;  // threshold for gc_old_counter
+    int gc_old_counter;    // objects promoted since last full gc
+    int run_depth;         // runs and host-called natives, see `ManagedHeap__can_promote()`
     bool gc_enabled;
     py_TValue debug_callback;
+#if PK_ENABLE_THREADS
+    c11_thrdpool* gc_workers;  // helper threads of full collections, or NULL
+#endif
 } ManagedHeap;
 
 typedef struct {
@@ -26,6 +51,7 @@ typedef struct {
     int* small_types;
     int* large_types;
 
+    bool is_minor;
     int small_freed;
     int large_freed;
 
@@ -47,6 +73,10 @@ void ManagedHeapSwpetInfo__delete(ManagedHeapSwpetInfo* self);
 
 int ManagedHeap__collect_hint(ManagedHeap* self);
 int ManagedHeap__collect(ManagedHeap* self);
+int ManagedHeap__collect_young(ManagedHeap* self);
+bool ManagedHeap__step(ManagedHeap* self, int budget_us);
+bool ManagedHeap__finish_sweep(ManagedHeap* self);
+void ManagedHeap__set_threads(ManagedHeap* self, int n);
 int ManagedHeap__sweep(ManagedHeap* self, ManagedHeapSwpetInfo* out_info);
 
 #define ManagedHeap__new(self, type, slots, udsize)                                                \
@@ -55,3 +85,9 @@ PyObject* ManagedHeap__gcnew(ManagedHeap* self, py_Type type, int slots, int uds
 
 // external implementation
 void ManagedHeap__mark(ManagedHeap* self);
+void ManagedHeap__mark_young(ManagedHeap* self);
+void ManagedHeap__mark_roots(ManagedHeap* self);
+bool ManagedHeap__mark_until(ManagedHeap* self, int64_t deadline_ns);
+#if PK_ENABLE_THREADS
+void ManagedHeap__mark_parallel(ManagedHeap* self, c11_thrdpool* workers);
+#endif
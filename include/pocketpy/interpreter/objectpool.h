@@ -2,37 +2,88 @@
 
 #include "pocketpy/common/vector.h"
 #include "pocketpy/common/str.h"
+#include "pocketpy/common/threads.h"
+#include "pocketpy/objects/base.h"
 
 #define kPoolArenaSize (120 * 1024)
-#define kMultiPoolCount 5
-// #define kPoolMaxBlockSize (32 * kMultiPoolCount)
+#define kPoolArenaMinSize (kPoolArenaSize / 8)
+#define kLargePoolMaxFreeSize (1024 * 1024)
+
+#if PK_POOL_SIZE_STEP % 8 != 0 || PK_POOL_MAX_SIZE % PK_POOL_SIZE_STEP != 0
+#error "PK_POOL_SIZE_STEP must be a multiple of 8 and divide PK_POOL_MAX_SIZE"
+#endif
 
 typedef struct PoolArena {
     int block_size;
     int block_count;
     int unused_length;
-
-    union {
-        char data[kPoolArenaSize];
-        int64_t _align64;
-    };
-
-    int unused[];
+    int index;        // index in `Pool.arenas`
+    int unused_hint;  // `used[:unused_hint]` have no free block
+    int data_size;    // up to `kPoolArenaSize`, the first arenas of a pool are smaller
+    char* data;
+    uint64_t used[];  // bit `i` is set if block `i` is allocated, followed by `data`
 } PoolArena;
 
+typedef struct PoolYoungBlock {
+    PoolArena* arena;
+    void* ptr;
+} PoolYoungBlock;
+
 typedef struct Pool {
     c11_vector /* PoolArena* */ arenas;
+    c11_vector /* PoolYoungBlock */ young_blocks;  // allocated since the last promotion
     int available_index;
     int block_size;
+    int sweep_index;      // `arenas[sweep_index:]` are not swept yet, or -1
+    int64_t alloc_count;  // blocks allocated so far
 } Pool;
 
 typedef struct MultiPool {
-    Pool pools[kMultiPoolCount];
+    Pool* pools;  // one for each size class, in increasing block sizes
+    int count;
+    // index in `pools` of the smallest class for `size`, at `(size - 1) / PK_POOL_SIZE_STEP`
+    uint8_t size_classes[PK_POOL_MAX_SIZE / PK_POOL_SIZE_STEP];
 } MultiPool;
 
-void* MultiPool__alloc(MultiPool* self, int size);
-int MultiPool__sweep_dealloc(MultiPool* self, int* out_types);
+void* MultiPool__alloc(MultiPool* self, int size, c11_vector* remembered);
+int MultiPool__sweep_dealloc(MultiPool* self, int* out_types, bool promote);
+int MultiPool__sweep_young(MultiPool* self, int* out_types, bool promote);
+void MultiPool__sweep_begin(MultiPool* self);
+bool MultiPool__sweep_step(MultiPool* self, c11_vector* remembered);
+int MultiPool__count(MultiPool* self);
 void MultiPool__ctor(MultiPool* self);
 void MultiPool__dtor(MultiPool* self);
 size_t MultiPool__total_allocated_bytes(MultiPool* self);
-c11_string* MultiPool__summary(MultiPool* self);
\ No newline at end of file
+c11_string* MultiPool__summary(MultiPool* self);
+
+// objects above `PK_POOL_MAX_SIZE`, counted in 4 size classes per doubling
+// freed objects of the classes up to `PK_LARGE_POOL_MAX_SIZE` are kept in a list of their class,
+// up to `kLargePoolMaxFreeSize` bytes in total
+typedef struct LargePool {
+    int* live_count;          // objects of each class
+    int64_t* alloc_count;     // objects allocated so far of each class
+    int count;                // number of classes
+    c11_vector* free_blocks;  // `void*` of each cached class
+    int cached_count;         // number of cached classes
+    int min_shift;            // classes start after `1 << min_shift`, up to `PK_POOL_MAX_SIZE`
+    size_t total_size;        // bytes of the live objects, rounded up to their classes
+    size_t free_size;         // bytes of the blocks in `free_blocks`
+} LargePool;
+
+void* LargePool__alloc(LargePool* self, int size, uint8_t* out_class);
+void LargePool__dealloc(LargePool* self, void* ptr, uint8_t cls);
+void LargePool__ctor(LargePool* self);
+void LargePool__dtor(LargePool* self);
+c11_string* LargePool__summary(LargePool* self);
+
+#if PK_ENABLE_THREADS
+typedef struct PoolSweepType {
+    py_Dtor dtor;
+    bool deferred;  // `dtor` is not thread-safe, run it after the workers are joined
+} PoolSweepType;
+
+int MultiPool__sweep_dealloc_parallel(MultiPool* self,
+                                      c11_thrdpool* workers,
+                                      const PoolSweepType* types,
+                                      bool promote);
+#endif
\ No newline at end of file
@@ -16,6 +16,14 @@ typedef struct py_TypeInfo {
     bool is_python;  // is it a python class? (not derived from c object)
     bool is_final;  // can it be subclassed?
 
+    uint32_t version;  // tag for attribute inline caches, 0 if unassigned
+
+    uint32_t ctor_version;  // `version` the constructor was resolved for
+    py_TValue* ctor_init;   // borrowed python `__init__` if `__new__` is the default one
+
+    InstanceShape* shape;  // root shape of instances, created on first use
+    int inst_slots;        // number of slots of instances from `__slots__`, -1 for a `__dict__`
+
     bool (*getattribute)(py_Ref self, py_Name name) PY_RAISE PY_RETURN;
     bool (*setattribute)(py_Ref self, py_Name name, py_Ref val) PY_RAISE PY_RETURN;
     bool (*delattribute)(py_Ref self, py_Name name) PY_RAISE;
@@ -30,6 +38,10 @@ py_TypeInfo* pk_typeinfo(py_Type type);
 py_ItemRef pk_tpfindname(py_TypeInfo* ti, py_Name name);
 #define pk_tpfindmagic pk_tpfindname
 
+uint32_t py_TypeInfo__version(py_TypeInfo* self);
+void py_TypeInfo__modified(py_TypeInfo* self);
+bool py_TypeInfo__apply_slots(py_TypeInfo* self) PY_RAISE;
+
 py_Type pk_newtype(const char* name,
                    py_Type base,
                    const py_GlobalRef module,
@@ -26,9 +26,15 @@ typedef struct TraceInfo {
 } TraceInfo;
 
 typedef struct WatchdogInfo {
-    clock_t max_reset_time;
+    int64_t deadline;  // monotonic time in ns, 0 if inactive
+    int countdown;     // polls left before the next clock read
 } WatchdogInfo;
 
+typedef struct BudgetInfo {
+    py_i64 remaining;            // instructions left before suspending
+    const py_Frame* base_frame;  // base frame of the running task, NULL if none
+} BudgetInfo;
+
 typedef struct TypePointer {
     py_TypeInfo* ti;
     py_Dtor dtor;
@@ -38,13 +44,19 @@ typedef struct py_ModuleInfo {
     c11_string* package;
     c11_string* path;
     py_GlobalRef self;  // weakref to the original module object
+    uint32_t version;   // changed when the slots of `__dict__` change, never 0
 } py_ModuleInfo;
 
+void py_ModuleInfo__modified(py_ModuleInfo* self);
+
 typedef struct VM {
     py_Frame* top_frame;
 
     BinTree modules;
     c11_vector /*TypePointer*/ types;
+    uint32_t next_type_version;
+    uint32_t next_module_version;
+    uint32_t next_decl_uid;
 
     py_GlobalRef builtins;  // builtins module
     py_GlobalRef main;      // __main__ module
@@ -56,6 +68,7 @@ typedef struct VM {
 
     int recursion_depth;
     int max_recursion_depth;
+    int next_depth;  // `recursion_depth` of the innermost `py_next()` calling python, or -1
 
     py_TValue reg[14];  // users' registers
     void* ctx;          // user-defined context
@@ -67,6 +80,8 @@ typedef struct VM {
     
     TraceInfo trace_info;
     WatchdogInfo watchdog_info;
+    BudgetInfo budget_info;
+    bool is_instrumented;  // see `VM__update_instrumentation`
     LineProfiler line_profiler;
     py_TValue vectorcall_buffer[PK_MAX_CO_VARNAMES];
 
@@ -79,6 +94,9 @@ void VM__ctor(VM* self);
 void VM__dtor(VM* self);
 int VM__index(VM* self);
 
+// select the instrumented dispatch of `VM__run_top_frame` if trace or a task budget is active
+void VM__update_instrumentation(VM* self);
+
 void VM__push_frame(VM* self, py_Frame* frame);
 void VM__pop_frame(VM* self);
 
@@ -100,11 +118,16 @@ typedef enum FrameResult {
     RES_RETURN = 1,
     RES_CALL = 2,
     RES_YIELD = 3,
+    RES_SUSPEND = 4,  // the budget of the running task is exhausted
 } FrameResult;
 
 FrameResult VM__run_top_frame(VM* self);
+// run the top frame and its callers until `base_frame` returns
+FrameResult VM__run_frames(VM* self, const py_Frame* base_frame);
 
 FrameResult VM__vectorcall(VM* self, uint16_t argc, uint16_t kwargc, bool opcall);
+// call a native function, counted in `run_depth` when the host calls it directly
+bool VM__callcfunc(VM* self, py_CFunction f, int argc, py_Ref argv);
 
 const char* pk_opname(Opcode op);
 
@@ -152,9 +175,11 @@ py_Type pk_Exception__register();
 py_Type pk_StopIteration__register();
 py_Type pk_super__register();
 py_Type pk_property__register();
+py_Type pk_member_descriptor__register();
 py_Type pk_staticmethod__register();
 py_Type pk_classmethod__register();
 py_Type pk_generator__register();
+py_Type pk_task__register();
 py_Type pk_namedict__register();
 py_Type pk_code__register();
 
@@ -51,6 +51,7 @@ typedef struct Bytecode {
 
 void Bytecode__set_signed_arg(Bytecode* self, int arg);
 bool Bytecode__is_forward_jump(const Bytecode* self);
+Opcode Bytecode__base_op(const Bytecode* self);
 
 typedef struct BytecodeEx {
     int32_t lineno;       // line number for each bytecode
@@ -63,8 +64,52 @@ typedef struct CodeBlock {
     int32_t start;   // start index of this block in codes, inclusive
     int32_t end;     // end index of this block in codes, exclusive
     int32_t end2;    // ...
+    int32_t depth;   // values kept on the stack by the enclosing statements
 } CodeBlock;
 
+// An entry of the exception table, built from the try blocks.
+// Entering or leaving a try block executes nothing, the table is only searched on errors.
+typedef struct CodeHandler {
+    int32_t start;  // first instruction of the try body
+    int32_t end;    // end of the try body, where the except clauses start
+    int32_t depth;  // stack depth above the locals to unwind to
+} CodeHandler;
+
+// How the arguments of one call site map onto the locals of a python function.
+// Keyword names are constants of the call site, so a plan only depends on the callee.
+typedef struct CallPlan {
+    uint32_t decl_uid;   // `FuncDecl.uid` of the callee
+    int16_t argc;        // number of positional arguments, including `self`
+    int16_t nparams;     // number of positional and keyword parameters
+    int16_t kw_index[];  // local index of each keyword argument
+} CallPlan;
+
+typedef struct InlineCache {
+    union {
+        // attribute access
+        struct {
+            uint32_t version;  // type version the entry was filled for
+            uint16_t kind;
+            uint16_t index;  // index of an instance attribute in `shape`
+        };
+
+        // global lookup
+        struct {
+            uint32_t globals_version;
+            uint32_t builtins_version;
+        };
+
+        // adaptive instructions
+        uint32_t counter;
+    };
+
+    union {
+        py_TValue* value;  // borrowed from the `__dict__` of a type or module
+        CallPlan* plan;    // owned, for `OP_CALL`
+        InstanceShape* shape;
+    };
+} InlineCache;
+
 typedef struct CodeObject {
     SourceData_ src;
     c11_string* name;
@@ -75,23 +120,30 @@ typedef struct CodeObject {
     c11_vector /*T=py_TValue*/ consts;  // constants
     c11_vector /*T=py_Name*/ varnames;  // local variables
     c11_vector /*T=py_Name*/ names;     // non-local names
+    c11_vector /*T=py_Name*/ freevars;  // names captured from enclosing functions
     int nlocals;  // number of local variables
 
     c11_smallmap_n2d varnames_inv;
     c11_smallmap_n2d names_inv;
 
     c11_vector /*T=CodeBlock*/ blocks;
+    c11_vector /*T=CodeHandler*/ handlers;  // outer try blocks first
     c11_vector /*T=FuncDecl_*/ func_decls;
 
     int start_line;
     int end_line;
+
+    InlineCache* caches;  // one per bytecode, allocated on first execution
 } CodeObject;
 
 void CodeObject__ctor(CodeObject* self, SourceData_ src, c11_sv name);
 void CodeObject__dtor(CodeObject* self);
 int CodeObject__add_varname(CodeObject* self, py_Name name);
 int CodeObject__add_name(CodeObject* self, py_Name name);
+int CodeObject__add_freevar(CodeObject* self, py_Name name);
 void CodeObject__gc_mark(const CodeObject* self, c11_vector* p_stack);
+InlineCache* CodeObject__init_caches(CodeObject* self);
+void CodeObject__build_handlers(CodeObject* self);
 
 // Serialization
 void* CodeObject__dumps(const CodeObject* co, int* size);
@@ -103,6 +155,18 @@ typedef struct FuncDeclKwArg {
     py_TValue value;  // default value
 } FuncDeclKwArg;
 
+typedef enum CaptureKind {
+    CAPTURE_NONE,   // not captured, looked up in globals
+    CAPTURE_LOCAL,  // a local of the enclosing frame
+    CAPTURE_FREE,   // a captured value of the enclosing function
+    CAPTURE_SELF,   // the function itself, to allow recursion
+} CaptureKind;
+
+typedef struct FuncDeclCapture {
+    int32_t kind;
+    int32_t index;  // index in the enclosing co->varnames or co->freevars
+} FuncDeclCapture;
+
 typedef struct FuncDecl {
     RefCounted rc;
     CodeObject code;  // strong ref
@@ -113,11 +177,13 @@ typedef struct FuncDecl {
     int starred_arg;    // index in co->varnames, -1 if no *arg
     int starred_kwarg;  // index in co->varnames, -1 if no **kwarg
     bool nested;        // whether this function is nested
+    c11_vector /*T=FuncDeclCapture*/ captures;  // one per code.freevars
 
     char* docstring;
 
     FuncType type;
     c11_smallmap_n2d kw_to_index;
+    uint32_t uid;  // unique per VM, assigned on first use by a `CallPlan`
 } FuncDecl;
 
 typedef FuncDecl* FuncDecl_;
@@ -136,7 +202,7 @@ typedef struct Function {
     FuncDecl_ decl;
     py_GlobalRef module;    // maybe NULL, weak ref
     py_TValue globals;      // maybe nil, strong ref
-    NameDict* closure;      // maybe NULL, strong ref
+    py_TValue* closure;     // maybe NULL, values of decl->code.freevars
     PyObject* clazz;        // weak ref; for super()
     py_CFunction cfunc;     // wrapped C function; for decl-based binding
 } Function;
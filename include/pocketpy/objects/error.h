@@ -9,4 +9,8 @@ typedef struct{
     char msg[512];
 } Error;
 
-void py_BaseException__stpush(py_Frame* frame, py_Ref, SourceData_ src, int lineno, const char* func_name);
+// `src` and `lineno` are used only if `frame` is NULL
+void py_BaseException__stpush(py_Frame* frame, py_Ref, SourceData_ src, int lineno);
+// `StopIteration()` raises a `tp_StopIteration` value without an object (`is_ptr == false`),
+// which is allocated here only when python code or the public API needs to see it
+void py_BaseException__materialize(py_Ref self);
@@ -1,21 +1,26 @@
 #pragma once
 
+#include "pocketpy/objects/codeobject.h"
 #include "pocketpy/objects/sourcedata.h"
 #include "pocketpy/objects/base.h"
 
+// names and line numbers are looked up only when the traceback is formatted
 typedef struct BaseExceptionFrame {
-    SourceData_ src;
-    int lineno;
-    c11_string* name;
-    py_TValue locals;   // for debugger only
-    py_TValue globals;  // for debugger only
+    FuncDecl_ decl;   // strong ref, NULL for module-level code
+    SourceData_ src;  // strong ref, only if `decl` is NULL
+    int pos;          // `ip` in `decl->code`, or a line number if `decl` is NULL
 } BaseExceptionFrame;
 
+SourceData_ BaseExceptionFrame__src(const BaseExceptionFrame* self);
+int BaseExceptionFrame__lineno(const BaseExceptionFrame* self);
+const char* BaseExceptionFrame__name(const BaseExceptionFrame* self);
+
 typedef struct BaseException {
     py_TValue args;
     py_TValue inner_exc;
     c11_vector /*T=BaseExceptionFrame*/ stacktrace;
+    c11_vector /*T=py_TValue*/ snapshots;  // locals and globals per frame, for debugger only
 } BaseException;
 
 char* safe_stringify_exception(py_Ref exc);
-char* formatexc_internal(py_Ref exc);
\ No newline at end of file
+char* formatexc_internal(py_Ref exc);
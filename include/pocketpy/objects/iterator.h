@@ -13,3 +13,18 @@ typedef struct list_iterator {
     c11_vector* vec;
     int index;
 } list_iterator;
+
+typedef struct Range {
+    py_i64 start;
+    py_i64 stop;
+    py_i64 step;
+} Range;
+
+typedef struct RangeIterator {
+    Range range;
+    py_i64 current;
+} RangeIterator;
+
+// `for i in range(...)` keeps its iterator unboxed on the value stack,
+// as a trivial `tp_range_iterator` value of {current, stop} with the step in `extra`
+bool pk_newrangecounter(py_OutRef out, int argc, py_Ref argv);
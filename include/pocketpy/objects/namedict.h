@@ -1,6 +1,7 @@
 #pragma once
 
 #include "pocketpy/objects/base.h"
+#include "pocketpy/common/vector.h"
 #include "pocketpy/pocketpy.h"
 
 typedef struct NameDict_KV {
@@ -8,22 +9,57 @@ typedef struct NameDict_KV {
     py_TValue value;
 } NameDict_KV;
 
+// A shape is the layout of attributes shared by instances that added the same keys in the
+// same order. Shapes form a tree, each child has one more key than its parent.
+typedef struct InstanceShape {
+    struct InstanceShape* parent;  // NULL for the root
+    int length;                    // number of keys
+    int max_length;                // max length of the subtree, to size new `values`
+    int count;                     // number of shapes in the tree, only for the root
+    py_Name* keys;
+    c11_vector /*T=InstanceShape* */ children;
+} InstanceShape;
+
+InstanceShape* InstanceShape__new_root();
+void InstanceShape__delete(InstanceShape* self);
+int InstanceShape__index(const InstanceShape* self, py_Name key);
+
 // https://github.com/pocketpy/pocketpy/blob/v1.x/include/pocketpy/namedict.h
 typedef struct NameDict {
     int length;
     float load_factor;
     int capacity;
-    int critical_size;
-    uintptr_t mask;
-    NameDict_KV* items;
+    int critical_size;  // -1 if the dict is shaped
+
+    union {
+        // hash table
+        struct {
+            uintptr_t mask;
+            NameDict_KV* items;
+        };
+
+        // shaped, `values[i]` belongs to `shape->keys[i]`
+        struct {
+            InstanceShape* shape;
+            py_TValue* values;
+        };
+    };
 } NameDict;
 
+#define NameDict__is_shaped(self) ((self)->critical_size < 0)
+
 NameDict* NameDict__new(float load_factor);
 void NameDict__delete(NameDict* self);
 void NameDict__ctor(NameDict* self, float load_factor);
+void NameDict__ctor_shaped(NameDict* self, InstanceShape* root);
 void NameDict__dtor(NameDict* self);
 py_TValue* NameDict__try_get(NameDict* self, py_Name key);
 bool NameDict__contains(NameDict* self, py_Name key);
 void NameDict__set(NameDict* self, py_Name key, py_TValue* value);
 bool NameDict__del(NameDict* self, py_Name key);
-void NameDict__clear(NameDict* self);
\ No newline at end of file
+void NameDict__clear(NameDict* self);
+
+// items are at positions [0, NameDict__end(self)), empty positions have a NULL key
+int NameDict__end(NameDict* self);
+py_Name NameDict__key_at(NameDict* self, int i);
+py_TValue* NameDict__value_at(NameDict* self, int i);
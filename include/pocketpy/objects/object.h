@@ -2,34 +2,75 @@
 
 #include "pocketpy/objects/namedict.h"
 #include "pocketpy/objects/base.h"
+#include "pocketpy/common/threads.h"
 
 typedef struct PyObject {
     py_Type type;  // we have a duplicated type here for convenience
-    uint8_t size_8b;
-    uint8_t gc_marked;  // lsb (self is marked), 2nd lsb (no recursively mark)
+    uint8_t size_8b;    // size class of a large object, see `LargePool`
+    uint8_t gc_marked;  // see `PK_GC_*` bits below
     int slots;          // number of slots in the object
     char flex[];
 } PyObject;
 
+#define PK_GC_MARKED 0b0001      // self is marked
+#define PK_GC_UNTRACKED 0b0010   // no recursively mark
+#define PK_GC_OLD 0b0100         // survived a collection at the top level
+#define PK_GC_REMEMBERED 0b1000  // old and may point to young objects
+#define PK_GC_GRAY 0b10000       // marked, but queued for tracing by an incremental gc
+
 // slots >= 0, allocate N slots
 // slots == -1, allocate a dict
 
 // | HEADER | <N slots> | <userdata>
 // | HEADER | <dict>    | <userdata>
 
+// these accessors are the write barrier of the gc, once its memory is handed out
+// an old object is remembered and a marked object is traced again
 py_TValue* PyObject__slots(PyObject* self);
 NameDict* PyObject__dict(PyObject* self);
 void* PyObject__userdata(PyObject* self);
 
 #define PK_OBJ_SLOTS_SIZE(slots) ((slots) >= 0 ? sizeof(py_TValue) * (slots) : sizeof(NameDict))
 
+// raw accessors for the gc itself and for code that never stores objects into the memory
+#define PyObject__slots_raw(self) ((py_TValue*)(self)->flex)
+#define PyObject__dict_raw(self) ((NameDict*)(self)->flex)
+#define PyObject__userdata_raw(self) ((void*)((self)->flex + PK_OBJ_SLOTS_SIZE((self)->slots)))
+
+// external implementation
+void PyObject__write_barrier_slow(PyObject* self);
+
+// untracked objects are never traced, there is no need to remember them
+#define PyObject__write_barrier(self)                                                              \
+    if(((self)->gc_marked & (PK_GC_OLD | PK_GC_REMEMBERED | PK_GC_UNTRACKED)) == PK_GC_OLD ||      \
+       ((self)->gc_marked & (PK_GC_MARKED | PK_GC_GRAY | PK_GC_UNTRACKED)) == PK_GC_MARKED)        \
+    PyObject__write_barrier_slow(self)
+
 void PyObject__dtor(PyObject* self);
 
+#if PK_ENABLE_THREADS
+// set by the threads of a parallel mark, the marks are set atomically meanwhile
+extern _Thread_local bool pk_gc_marking_parallel;
+
+#define PyObject__gc_marked_atomic(self) ((_Atomic(uint8_t)*)&(self)->gc_marked)
+
+// set `PK_GC_MARKED`, returns true if it was not set
+#define PyObject__try_mark(self)                                                                   \
+    (!pk_gc_marking_parallel                                                                       \
+         ? (!((self)->gc_marked & PK_GC_MARKED) && ((self)->gc_marked |= PK_GC_MARKED))            \
+         : (!(atomic_load_explicit(PyObject__gc_marked_atomic(self), memory_order_relaxed) &       \
+              PK_GC_MARKED) &&                                                                     \
+            !(atomic_fetch_or_explicit(PyObject__gc_marked_atomic(self),                           \
+                                       PK_GC_MARKED,                                               \
+                                       memory_order_relaxed) &                                     \
+              PK_GC_MARKED)))
+#else
+#define PyObject__try_mark(self)                                                                   \
+    (!((self)->gc_marked & PK_GC_MARKED) && ((self)->gc_marked |= PK_GC_MARKED))
+#endif
+
 #define pk__mark_value(val)                                                                        \
     if((val)->is_ptr) {                                                                            \
         PyObject* obj = (val)->_obj;                                                               \
-        if(!(obj->gc_marked & 0b01)) {                                                             \
-            obj->gc_marked |= 0b01;                                                                \
-            if(!(obj->gc_marked & 0b10)) { c11_vector__push(PyObject*, p_stack, obj); }            \
-        }                                                                                          \
+        if(PyObject__try_mark(obj)) c11_vector__push(PyObject*, p_stack, obj);                     \
     }
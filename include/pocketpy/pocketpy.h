@@ -130,6 +130,13 @@ PK_API void py_sys_setargv(int argc, char** argv);
 PK_API void py_sys_settrace(py_TraceFunc func, bool reset);
 /// Invoke the garbage collector.
 PK_API int py_gc_collect();
+/// Run the incremental garbage collector for about `budget_us` microseconds.
+/// Return true if a collection cycle was completed.
+PK_API bool py_gc_step(int budget_us);
+/// Use `n` threads for the full collections of large heaps, `1` by default.
+/// This has no effect if pocketpy is built without `PK_ENABLE_THREADS`.
+/// Dtors of the builtin types may run on the other threads, so `PK_FREE` must be thread-safe.
+PK_API void py_gc_setthreads(int n);
 
 /// Wrapper for `PK_MALLOC(size)`.
 PK_API void* py_malloc(size_t size);
@@ -198,6 +205,19 @@ PK_API bool py_smartexec(const char* source, py_Ref module, ...) PY_RAISE PY_RET
 /// `int res = py_toint(py_retval());`
 /// `// res will be 3`.
 PK_API bool py_smarteval(const char* source, py_Ref module, ...) PY_RAISE PY_RETURN;
+/// Compile a source string into a task which can be run in slices by `py_exec_budget`.
+/// The task is not started. Parameters are the same as `py_exec`.
+PK_API bool py_newtask(py_OutRef out,
+                       const char* source,
+                       const char* filename,
+                       enum py_CompileMode mode,
+                       py_Ref module) PY_RAISE;
+/// Run or resume a task until it finishes or `max_instructions` bytecodes have been executed.
+/// The task cannot be suspended while running a native function (e.g. iterating a generator),
+/// so it may exceed `max_instructions` and suspend right after that function returns.
+/// @return `1` if the task is finished and the result is stored in `py_retval()`,
+/// `0` if the task is suspended, or `-1` if an exception is raised.
+PK_API int py_exec_budget(py_Ref task, py_i64 max_instructions) PY_RAISE PY_RETURN;
 
 /************* Value Creation *************/
 
@@ -312,6 +332,7 @@ PK_API bool py_tobool(py_Ref);
 /// Convert a `type` object in python to `py_Type`.
 PK_API py_Type py_totype(py_Ref);
 /// Convert a user-defined object to its userdata.
+/// Fetch it again after calling into python instead of keeping the pointer for writes.
 PK_API void* py_touserdata(py_Ref);
 /// Convert a `str` object in python to null-terminated string.
 PK_API const char* py_tostr(py_Ref);
@@ -788,6 +809,7 @@ PK_API bool py_pickle_loads(const unsigned char* data, int size) PY_RAISE PY_RET
 /// `PK_ENABLE_WATCHDOG` must be defined to `1` to use this feature.
 /// You need to call `py_watchdog_end()` later.
 /// If `timeout` is reached, `TimeoutError` will be raised.
+/// The deadline is checked at loop back-edges and function calls.
 PK_API void py_watchdog_begin(py_i64 timeout);
 /// Reset the watchdog.
 PK_API void py_watchdog_end();
@@ -901,6 +923,9 @@ enum py_PredefinedType {
     tp_array2d,
     tp_array2d_view,
     tp_chunked_array2d,
+    /* appended to keep the ids above stable */
+    tp_task,               // 3 slots (backup, code, module)
+    tp_member_descriptor,  // slot index + name
 };
 
 #ifndef PK_IS_AMALGAMATED_C
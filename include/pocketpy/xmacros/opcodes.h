@@ -24,7 +24,7 @@ OPCODE(LOAD_NULL)
 /**************************/
 OPCODE(LOAD_FAST)
 OPCODE(LOAD_NAME)
-OPCODE(LOAD_NONLOCAL)
+OPCODE(LOAD_DEREF)
 OPCODE(LOAD_GLOBAL)
 OPCODE(LOAD_ATTR)
 OPCODE(LOAD_SELF_ATTR)
@@ -104,6 +104,8 @@ OPCODE(UNARY_INVERT)
 /**************************/
 OPCODE(GET_ITER)
 OPCODE(FOR_ITER)
+OPCODE(GET_RANGE_ITER)
+OPCODE(FOR_RANGE)
 /**************************/
 OPCODE(IMPORT_PATH)
 OPCODE(POP_IMPORT_STAR)
@@ -119,15 +121,27 @@ OPCODE(ADD_CLASS_ANNOTATION)
 OPCODE(WITH_ENTER)
 OPCODE(WITH_EXIT)
 /**************************/
-OPCODE(BEGIN_TRY)
-OPCODE(END_TRY)
 OPCODE(EXCEPTION_MATCH)
 OPCODE(HANDLE_EXCEPTION)
 OPCODE(RAISE)
 OPCODE(RAISE_ASSERT)
 OPCODE(RE_RAISE)
-OPCODE(PUSH_EXCEPTION)
 /**************************/
 OPCODE(FORMAT_STRING)
 /**************************/
+// superinstructions, the fused instruction is kept in place and skipped
+OPCODE(LOAD_FAST_LOAD_FAST)
+OPCODE(LOAD_FAST_LOAD_CONST)
+OPCODE(LOAD_FAST_LOAD_ATTR)
+OPCODE(COMPARE_JUMP_IF_FALSE)
+OPCODE(FOR_RANGE_STORE_FAST)
+/**************************/
+// specialized forms created at runtime by quickening, never serialized
+OPCODE(FOR_ITER_LIST)
+OPCODE(FOR_ITER_TUPLE)
+OPCODE(FOR_ITER_RANGE)
+OPCODE(CALL_PY_EXACT_ARGS)
+OPCODE(CALL_PY_PLANNED)
+OPCODE(LOAD_SUBSCR_LIST_INT)
+/**************************/
 #endif
@@ -9,20 +9,50 @@ def enable() -> None:
 def disable() -> None:
     """Disable automatic garbage collection."""
 
-def collect() -> int:
-    """Run a full collection immediately.
+def collect(generation: int = 2) -> int:
+    """Run a collection immediately.
 
+    Generation `2` is a full collection, `0` and `1` only collect young objects.
     Returns an integer indicating the number of unreachable objects found.
     """
 
 def collect_hint() -> int:
     """Hint the garbage collector to run a collection.
 
+    Most collections only visit young objects, so the pause grows with
+    the garbage produced since the last one rather than the live heap.
+    Full collections only mark the heap, arenas are swept when the allocator needs
+    free blocks from them, by `gc.step()` or by `gc.finish_sweep()`.
+
     The typical usage scenario for this function is in frame-driven games,
     where `gc.disable()` is called at the start of the game,
     and `gc.collect_hint()` is called at the end of each frame.
     """
 
+def step(budget_us: int) -> bool:
+    """Run the incremental garbage collector for about `budget_us` microseconds.
+
+    A cycle is started once enough objects were allocated since the last one,
+    then each call marks or sweeps a part of the heap. Returns true if the call completed a cycle.
+    Other collections complete the cycle in progress at once,
+    so call `gc.disable()` to leave the work to this function, e.g. in the idle time of each frame.
+    This function does nothing if python is called from a native function.
+    """
+
+def finish_sweep() -> bool:
+    """Sweep the arenas left by the last automatic full collection.
+
+    Returns true if a sweep was in progress. `gc.step()` does the same a few arenas at a time.
+    """
+
+def set_threads(n: int) -> None:
+    """Use `n` threads to mark and sweep in full collections of large heaps, `1` by default.
+
+    The calling thread is one of them, the others are started by this function.
+    Young and incremental collections always run on the calling thread.
+    This function does nothing if pocketpy is built without threads.
+    """
+
 def setup_debug_callback(cb: Callable[[Literal['start', 'stop'], str], None] | None) -> None:
     """Setup a callback that will be triggered at the end of each collection."""
 
@@ -32,6 +32,19 @@ def watchdog_begin(timeout: int):
 def watchdog_end() -> None:
     """End the watchdog after a call to `watchdog_begin()`."""
 
+class Task:
+    """Source code that runs in slices of bytecodes and keeps its frames between slices."""
+    def __new__(cls, source: str, mode: Literal['exec', 'eval'] = 'exec') -> Self: ...
+
+    @property
+    def is_done(self) -> bool: ...
+
+    def run(self, max_instructions: int) -> bool:
+        """Run or resume the task for at most `max_instructions` bytecodes.
+
+        Return `True` if the task is finished or `False` if it is suspended.
+        """
+
 def profiler_begin() -> None: ...
 def profiler_end() -> None: ...
 def profiler_reset() -> None: ...
@@ -9,9 +9,15 @@ def _get_annotations(cls: type):
         res.update(cls.__annotations__)
     return res.keys()
 
+def _get_defaults(cls: type):
+    cls_d = cls.__dict__
+    if '__dataclass_defaults__' in cls_d:   # slots=True
+        return cls_d['__dataclass_defaults__']
+    return cls_d
+
 def _wrapped__init__(self, *args, **kwargs):
     cls = type(self)
-    cls_d = cls.__dict__
+    cls_d = _get_defaults(cls)
     fields = _get_annotations(cls)
     i = 0   # index into args
     for field in fields:
@@ -32,8 +38,7 @@ def _wrapped__init__(self, *args, **kwargs):
 
 def _wrapped__repr__(self):
     fields = _get_annotations(type(self))
-    obj_d = self.__dict__
-    args: list = [f"{field}={obj_d[field]!r}" for field in fields]
+    args: list = [f"{field}={getattr(self, field)!r}" for field in fields]
     return f"{type(self).__name__}({', '.join(args)})"
 
 def _wrapped__eq__(self, other):
@@ -48,7 +53,25 @@ def _wrapped__eq__(self, other):
 def _wrapped__ne__(self, other):
     return not self.__eq__(other)
 
-def dataclass(cls: type):
+def _add_slots(cls: type):
+    cls_d = cls.__dict__
+    base_fields = [] if cls.__base__ is object else list(_get_annotations(cls.__base__))
+    defaults = {}
+    slots = []
+    for field in cls.__annotations__.keys():
+        if field in base_fields:
+            continue
+        if field in cls_d:
+            defaults[field] = cls_d[field]
+            delattr(cls, field)
+        slots.append(field)
+    cls.__dataclass_defaults__ = defaults
+    # applied when the class statement ends
+    cls.__slots__ = tuple(slots)
+
+def dataclass(cls: type = None, slots=False):
+    if cls is None:
+        return lambda cls: dataclass(cls, slots=slots)
     assert type(cls) is type
     cls_d = cls.__dict__
     if '__init__' not in cls_d:
@@ -59,10 +82,13 @@ def dataclass(cls: type):
         cls.__eq__ = _wrapped__eq__
     if '__ne__' not in cls_d:
         cls.__ne__ = _wrapped__ne__
+    if slots:
+        _add_slots(cls)
     fields = _get_annotations(cls)
+    defaults = _get_defaults(cls)
     has_default = False
     for field in fields:
-        if field in cls_d:
+        if field in defaults:
             has_default = True
         else:
             if has_default:
@@ -71,5 +97,4 @@ def dataclass(cls: type):
 
 def asdict(obj) -> dict:
     fields = _get_annotations(type(obj))
-    obj_d = obj.__dict__
-    return {field: obj_d[field] for field in fields}
\ No newline at end of file
+    return {field: getattr(obj, field) for field in fields}
\ No newline at end of file
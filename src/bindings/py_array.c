@@ -2,14 +2,17 @@
 #include "pocketpy/objects/object.h"
 #include "pocketpy/objects/iterator.h"
 #include "pocketpy/interpreter/vm.h"
+#include "pocketpy/interpreter/types.h"
 
+// the view is read-only, so it skips the write barrier
 int pk_arrayview(py_Ref self, py_TValue** p) {
     if(self->type == tp_list) {
-        *p = py_list_data(self);
-        return py_list_len(self);
+        List* ud = PyObject__userdata_raw(self->_obj);
+        *p = ud->data;
+        return ud->length;
     }
     if(self->type == tp_tuple) {
-        *p = PyObject__slots(self->_obj);
+        *p = PyObject__slots_raw(self->_obj);
         return py_tuple_len(self);
     }
     return -1;
@@ -61,13 +61,13 @@ static bool namedict_items(int argc, py_Ref argv) {
     py_Ref object = py_getslot(argv, 0);
     NameDict* dict = PyObject__dict(object->_obj);
     py_newlist(py_retval());
-    for(int i = 0; i < dict->capacity; i++) {
-        NameDict_KV* kv = &dict->items[i];
-        if(kv->key == NULL) continue;
+    for(int i = 0; i < NameDict__end(dict); i++) {
+        py_Name key = NameDict__key_at(dict, i);
+        if(key == NULL) continue;
         py_Ref slot = py_list_emplace(py_retval());
         py_Ref p = py_newtuple(slot, 2);
-        p[0] = *py_name2ref(kv->key);
-        p[1] = kv->value;
+        p[0] = *py_name2ref(key);
+        p[1] = *NameDict__value_at(dict, i);
     }
     return true;
 }
@@ -75,8 +75,7 @@ static bool namedict_items(int argc, py_Ref argv) {
 static bool namedict_clear(int argc, py_Ref argv) {
     PY_CHECK_ARGC(1);
     py_Ref object = py_getslot(argv, 0);
-    NameDict* dict = PyObject__dict(object->_obj);
-    NameDict__clear(dict);
+    py_cleardict(object);
     py_newnone(py_retval());
     return true;
 }
@@ -9,7 +9,7 @@ bool pk__object_new(int argc, py_Ref argv) {
     if(!ti->is_python) {
         return TypeError("object.__new__(%t) is not safe, use %t.__new__() instead", cls, cls);
     }
-    py_newobject(py_retval(), cls, -1, 0);
+    py_newobject(py_retval(), cls, ti->inst_slots, 0);
     return true;
 }
 
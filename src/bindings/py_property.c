@@ -49,3 +49,18 @@ py_Type pk_property__register() {
     py_bindproperty(type, "fset", property_fset, NULL);
     return type;
 }
+
+static bool member_descriptor__repr__(int argc, py_Ref argv) {
+    PY_CHECK_ARGC(1);
+    c11_sbuf buf;
+    c11_sbuf__ctor(&buf);
+    pk_sprintf(&buf, "<member '%n'>", (py_Name)argv->_ptr);
+    c11_sbuf__py_submit(&buf, py_retval());
+    return true;
+}
+
+py_Type pk_member_descriptor__register() {
+    py_Type type = pk_newtype("member_descriptor", tp_object, NULL, NULL, false, true);
+    py_bindmagic(type, __repr__, member_descriptor__repr__);
+    return type;
+}
@@ -2,14 +2,9 @@
 
 #include "pocketpy/common/utils.h"
 #include "pocketpy/objects/object.h"
+#include "pocketpy/objects/iterator.h"
 #include "pocketpy/interpreter/vm.h"
 
-typedef struct Range {
-    py_i64 start;
-    py_i64 stop;
-    py_i64 step;
-} Range;
-
 static bool range__new__(int argc, py_Ref argv) {
     Range* ud = py_newobject(py_retval(), tp_range, 0, sizeof(Range));
     switch(argc - 1) {  // skip cls
@@ -54,10 +49,26 @@ py_Type pk_range__register() {
     return type;
 }
 
-typedef struct RangeIterator {
-    Range range;
-    py_i64 current;
-} RangeIterator;
+bool pk_newrangecounter(py_OutRef out, int argc, py_Ref argv) {
+    for(int i = 0; i < argc; i++) {
+        if(argv[i].type != tp_int) return false;
+    }
+    py_i64 counter[2] = {0, 0};  // {current, stop}
+    py_i64 step = 1;
+    switch(argc) {
+        case 1: counter[1] = argv[0]._i64; break;
+        case 3: step = argv[2]._i64;  // fallthrough
+        case 2:
+            counter[0] = argv[0]._i64;
+            counter[1] = argv[1]._i64;
+            break;
+        default: return false;
+    }
+    if(step == 0 || step < INT32_MIN || step > INT32_MAX) return false;
+    py_newtrivial(out, tp_range_iterator, counter, sizeof(counter));
+    out->extra = (int)step;
+    return true;
+}
 
 static bool range_iterator__new__(int argc, py_Ref argv) {
     PY_CHECK_ARGC(2);
@@ -12,7 +12,8 @@ c11_string* pk_tostr(py_Ref self) {
     if(!self->is_ptr) {
         return (c11_string*)(&self->extra);
     } else {
-        return PyObject__userdata(self->_obj);
+        // strings have no children, skip the write barrier
+        return PyObject__userdata_raw(self->_obj);
     }
 }
 
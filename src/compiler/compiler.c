@@ -29,6 +29,7 @@ typedef struct ExprVt {
     bool is_starred;  // StarredExpr
     bool is_binary;   // BinaryExpr
     bool is_ternary;  // TernaryExpr
+    bool is_call;     // CallExpr
     void (*dtor)(Expr*);
 } ExprVt;
 
@@ -63,6 +64,7 @@ typedef struct Ctx {
     py_Name n_self;
     int level;
     int curr_iblock;
+    int stmt_depth;  // values kept on the stack by the statements being compiled
     bool is_compiling_class;
     c11_vector /*T=Expr_p*/ s_expr;
     c11_smallmap_n2d global_names;
@@ -81,6 +83,7 @@ static int Ctx__emit_int(Ctx* self, int64_t value, int line);
 static int Ctx__emit_name(Ctx* self, py_Name name, int line);
 static void Ctx__patch_jump(Ctx* self, int index);
 static void Ctx__emit_jump(Ctx* self, int target, int line);
+static Opcode Ctx__emit_iter(Ctx* self, Expr* iter);
 static int Ctx__add_varname(Ctx* self, py_Name name);
 static int Ctx__add_name(Ctx* self, py_Name name);
 static int Ctx__add_const(Ctx* self, py_Ref);
@@ -108,7 +111,7 @@ void NameExpr__emit_(Expr* self_, Ctx* ctx) {
         // we know this is a local variable
         Ctx__emit_(ctx, OP_LOAD_FAST, index, self->line);
     } else {
-        Opcode op = ctx->level <= 1 ? OP_LOAD_GLOBAL : OP_LOAD_NONLOCAL;
+        Opcode op = ctx->level <= 1 ? OP_LOAD_GLOBAL : OP_LOAD_DEREF;
         if(self->scope == NAME_GLOBAL) {
             if(ctx->co->src->is_dynamic) {
                 op = OP_LOAD_NAME;
@@ -120,7 +123,12 @@ void NameExpr__emit_(Expr* self_, Ctx* ctx) {
                 }
             }
         }
-        Ctx__emit_(ctx, op, Ctx__add_name(ctx, self->name), self->line);
+        if(op == OP_LOAD_DEREF) {
+            // resolved by `resolve_freevars()` when the enclosing scope is done
+            Ctx__emit_(ctx, op, CodeObject__add_freevar(ctx->co, self->name), self->line);
+        } else {
+            Ctx__emit_(ctx, op, Ctx__add_name(ctx, self->name), self->line);
+        }
     }
 }
 
@@ -594,10 +602,9 @@ void CompExpr__dtor(Expr* self_) {
 void CompExpr__emit_(Expr* self_, Ctx* ctx) {
     CompExpr* self = (CompExpr*)self_;
     Ctx__emit_(ctx, self->op0, 0, self->line);
-    vtemit_(self->iter, ctx);
-    Ctx__emit_(ctx, OP_GET_ITER, BC_NOARG, BC_KEEPLINE);
+    Opcode for_iter = Ctx__emit_iter(ctx, self->iter);
     int block = Ctx__enter_block(ctx, CodeBlockType_FOR_LOOP);
-    int block_start = Ctx__emit_(ctx, OP_FOR_ITER, block, BC_KEEPLINE);
+    int block_start = Ctx__emit_(ctx, for_iter, block, BC_KEEPLINE);
     bool ok = vtemit_store(self->vars, ctx);
     // this error occurs in `vars` instead of this line, but...nevermind
     assert(ok);  // this should raise a SyntaxError, but we just assert it
@@ -1136,7 +1143,7 @@ void CallExpr__emit_(Expr* self_, Ctx* ctx) {
 }
 
 CallExpr* CallExpr__new(int line, Expr* callable) {
-    const static ExprVt Vt = {.dtor = CallExpr__dtor, .emit_ = CallExpr__emit_};
+    const static ExprVt Vt = {.dtor = CallExpr__dtor, .emit_ = CallExpr__emit_, .is_call = true};
     CallExpr* self = PK_MALLOC(sizeof(CallExpr));
     self->vt = &Vt;
     self->line = line;
@@ -1153,6 +1160,7 @@ static void Ctx__ctor(Ctx* self, CodeObject* co, FuncDecl* func, int level, py_N
     self->n_self = n_self;
     self->level = level;
     self->curr_iblock = 0;
+    self->stmt_depth = 0;
     self->is_compiling_class = false;
     c11_vector__ctor(&self->s_expr, sizeof(Expr*));
     c11_smallmap_n2d__ctor(&self->global_names);
@@ -1188,12 +1196,9 @@ static int Ctx__prepare_loop_divert(Ctx* self, int line, bool is_break) {
                 Ctx__emit_(self, OP_POP_TOP, BC_NOARG, line);
                 break;
             }
-            case CodeBlockType_TRY: {
-                Ctx__emit_(self, OP_END_TRY, BC_NOARG, line);
-                break;
-            }
             case CodeBlockType_EXCEPT: {
-                Ctx__emit_(self, OP_END_TRY, BC_NOARG, line);
+                // discard the handled exception
+                Ctx__emit_(self, OP_POP_TOP, BC_NOARG, line);
                 break;
             }
             default: break;
@@ -1204,7 +1209,7 @@ static int Ctx__prepare_loop_divert(Ctx* self, int line, bool is_break) {
 }
 
 static int Ctx__enter_block(Ctx* self, CodeBlockType type) {
-    CodeBlock block = {type, self->curr_iblock, self->co->codes.length, -1, -1};
+    CodeBlock block = {type, self->curr_iblock, self->co->codes.length, -1, -1, self->stmt_depth};
     c11_vector__push(CodeBlock, &self->co->blocks, block);
     self->curr_iblock = self->co->blocks.length - 1;
     return self->curr_iblock;
@@ -1232,6 +1237,30 @@ static void Ctx__s_emit_decorators(Ctx* self, int count) {
     }
 }
 
+// emits the iterator of a for loop and returns the opcode to advance it
+static Opcode Ctx__emit_iter(Ctx* self, Expr* iter) {
+    if(iter->vt->is_call) {
+        CallExpr* call = (CallExpr*)iter;
+        int argc = call->args.length;
+        bool is_range = call->callable->vt->is_name &&
+                        ((NameExpr*)call->callable)->name == py_name("range") &&
+                        call->kwargs.length == 0 && argc >= 1 && argc <= 3;
+        c11__foreach(Expr*, &call->args, e) {
+            if((*e)->vt->is_starred) is_range = false;
+        }
+        if(is_range) {
+            // `range` is checked at runtime, it may have been rebound
+            vtemit_(call->callable, self);
+            c11__foreach(Expr*, &call->args, e) { vtemit_(*e, self); }
+            Ctx__emit_(self, OP_GET_RANGE_ITER, argc, call->line);
+            return OP_FOR_RANGE;
+        }
+    }
+    vtemit_(iter, self);
+    Ctx__emit_(self, OP_GET_ITER, BC_NOARG, BC_KEEPLINE);
+    return OP_FOR_ITER;
+}
+
 static int Ctx__emit_(Ctx* self, Opcode opcode, uint16_t arg, int line) {
     Bytecode bc = {(uint16_t)opcode, arg};
     BytecodeEx bcx = {line, self->curr_iblock};
@@ -1566,6 +1595,107 @@ static void push_global_context(Compiler* self, CodeObject* co) {
     Ctx__ctor(ctx, co, NULL, self->contexts.length, self->n_self);
 }
 
+static Opcode superinstruction(Opcode first, Opcode second) {
+    switch(first) {
+        case OP_LOAD_FAST:
+            switch(second) {
+                case OP_LOAD_FAST: return OP_LOAD_FAST_LOAD_FAST;
+                case OP_LOAD_CONST: return OP_LOAD_FAST_LOAD_CONST;
+                case OP_LOAD_ATTR: return OP_LOAD_FAST_LOAD_ATTR;
+                default: return OP_NO_OP;
+            }
+        case OP_COMPARE_LT:
+        case OP_COMPARE_LE:
+        case OP_COMPARE_EQ:
+        case OP_COMPARE_NE:
+        case OP_COMPARE_GT:
+        case OP_COMPARE_GE:
+            return second == OP_POP_JUMP_IF_FALSE ? OP_COMPARE_JUMP_IF_FALSE : OP_NO_OP;
+        case OP_FOR_RANGE: return second == OP_STORE_FAST ? OP_FOR_RANGE_STORE_FAST : OP_NO_OP;
+        default: return OP_NO_OP;
+    }
+}
+
+// Fuse common instruction pairs. Only the opcode of the first instruction is replaced, the
+// second one stays in place for its argument and is skipped at runtime, so jump offsets, blocks
+// and `codes_ex` are not affected.
+static void fuse_superinstructions(CodeObject* co) {
+    int length = co->codes.length;
+    Bytecode* codes = co->codes.data;
+    BytecodeEx* codes_ex = co->codes_ex.data;
+    // the skipped instruction must not be entered from anywhere else
+    bool* is_target = PK_MALLOC(length + 1);
+    memset(is_target, 0, length + 1);
+    for(int i = 0; i < length; i++) {
+        if(Bytecode__is_forward_jump(&codes[i])) {
+            int target = i + (int16_t)codes[i].arg;
+            if(target >= 0 && target <= length) is_target[target] = true;
+        }
+    }
+    c11__foreach(CodeBlock, &co->blocks, block) {
+        if(block->start >= 0 && block->start <= length) is_target[block->start] = true;
+        if(block->end >= 0 && block->end <= length) is_target[block->end] = true;
+        if(block->end2 >= 0 && block->end2 <= length) is_target[block->end2] = true;
+    }
+    for(int i = 0; i + 1 < length; i++) {
+        if(is_target[i + 1]) continue;
+        // keep line events and exception handling exact
+        if(codes_ex[i].lineno != codes_ex[i + 1].lineno) continue;
+        if(codes_ex[i].iblock != codes_ex[i + 1].iblock) continue;
+        Opcode op = superinstruction(codes[i].op, codes[i + 1].op);
+        if(op == OP_NO_OP) continue;
+        if(op == OP_COMPARE_JUMP_IF_FALSE) codes[i].arg = codes[i].op;
+        codes[i].op = op;
+        i++;
+    }
+    PK_FREE(is_target);
+}
+
+// Decide where each free variable of the functions defined in `co` is captured from. It can be
+// a local of `co`, or a free variable of `func` itself if `func` is nested too. Otherwise it is a
+// global and its `LOAD_DEREF` instructions become `LOAD_GLOBAL`.
+static void resolve_freevars(CodeObject* co, FuncDecl* func) {
+    c11__foreach(FuncDecl_, &co->func_decls, p_decl) {
+        FuncDecl* decl = *p_decl;
+        CodeObject* inner = &decl->code;
+        if(inner->freevars.length == 0) continue;
+        py_Name self_name = py_namev(c11_string__sv(inner->name));
+        bool any_captured = false;
+        for(int i = 0; i < inner->freevars.length; i++) {
+            py_Name name = c11__getitem(py_Name, &inner->freevars, i);
+            FuncDeclCapture capture = {CAPTURE_NONE, -1};
+            if(decl->nested) {
+                int index = c11_smallmap_n2d__get(&co->varnames_inv, name, -1);
+                if(name == self_name) {
+                    capture.kind = CAPTURE_SELF;
+                } else if(index >= 0) {
+                    capture.kind = CAPTURE_LOCAL;
+                    capture.index = index;
+                } else if(func && func->nested) {
+                    capture.kind = CAPTURE_FREE;
+                    capture.index = CodeObject__add_freevar(co, name);
+                }
+            }
+            c11_vector__push(FuncDeclCapture, &decl->captures, capture);
+            any_captured |= capture.kind != CAPTURE_NONE;
+        }
+        Bytecode* codes = inner->codes.data;
+        for(int i = 0; i < inner->codes.length; i++) {
+            if(codes[i].op != OP_LOAD_DEREF) continue;
+            FuncDeclCapture* capture = c11__at(FuncDeclCapture, &decl->captures, codes[i].arg);
+            if(capture->kind != CAPTURE_NONE) continue;
+            py_Name name = c11__getitem(py_Name, &inner->freevars, codes[i].arg);
+            codes[i].op = OP_LOAD_GLOBAL;
+            codes[i].arg = CodeObject__add_name(inner, name);
+        }
+        if(!any_captured) {
+            // nothing to allocate when the function is created
+            c11_vector__clear(&inner->freevars);
+            c11_vector__clear(&decl->captures);
+        }
+    }
+}
+
 static Error* pop_context(Compiler* self) {
     // add a `return None` in the end as a guard
     // previously, we only do this if the last opcode is not a return
@@ -1597,13 +1727,17 @@ static Error* pop_context(Compiler* self) {
         } else if(bc->op == OP_LOOP_BREAK) {
             CodeBlock* block = c11__at(CodeBlock, &ctx()->co->blocks, bc->arg);
             Bytecode__set_signed_arg(bc, (block->end2 != -1 ? block->end2 : block->end) - i);
-        } else if(bc->op == OP_FOR_ITER || bc->op == OP_FOR_ITER_YIELD_VALUE) {
+        } else if(bc->op == OP_FOR_ITER || bc->op == OP_FOR_RANGE ||
+                  bc->op == OP_FOR_ITER_YIELD_VALUE) {
             CodeBlock* block = c11__at(CodeBlock, &ctx()->co->blocks, bc->arg);
             Bytecode__set_signed_arg(bc, block->end - i);
         }
     }
+    fuse_superinstructions(co);
+    CodeObject__build_handlers(co);
     // pre-compute func->is_simple
     FuncDecl* func = ctx()->func;
+    resolve_freevars(co, func);
     if(func) {
         // check generator
         Bytecode* codes = func->code.codes.data;
@@ -2130,6 +2264,7 @@ static Error* compile_match_case(Compiler* self, c11_vector* patches) {
     if(!consumed) return SyntaxError(self, "expected a new line after ':'");
 
     consume(TK_INDENT);
+    ctx()->stmt_depth++;  // [subject]
     while(curr()->type != TK_DEDENT) {
         match_newlines();
 
@@ -2156,6 +2291,7 @@ static Error* compile_match_case(Compiler* self, c11_vector* patches) {
         match_newlines();
     }
     consume(TK_DEDENT);
+    ctx()->stmt_depth--;
 
     for(int i = 0; i < patches->length; i++) {
         int patch = c11__getitem(int, patches, i);
@@ -2190,10 +2326,11 @@ static Error* compile_for_loop(Compiler* self) {
     check(EXPR_VARS(self));  // [vars]
     consume(TK_IN);
     check(EXPR_TUPLE(self));  // [vars, iter]
-    Ctx__s_emit_top(ctx());   // [vars]
-    Ctx__emit_(ctx(), OP_GET_ITER, BC_NOARG, BC_KEEPLINE);
+    Expr* iter = Ctx__s_popx(ctx());
+    Opcode for_iter = Ctx__emit_iter(ctx(), iter);  // [vars]
+    vtdelete(iter);
     int block = Ctx__enter_block(ctx(), CodeBlockType_FOR_LOOP);
-    int block_start = Ctx__emit_(ctx(), OP_FOR_ITER, block, BC_KEEPLINE);
+    int block_start = Ctx__emit_(ctx(), for_iter, block, BC_KEEPLINE);
     Expr* vars = Ctx__s_popx(ctx());
     bool ok = vtemit_store(vars, ctx());
     vtdelete(vars);
@@ -2201,7 +2338,9 @@ static Error* compile_for_loop(Compiler* self) {
         // this error occurs in `vars` instead of this line, but...nevermind
         return SyntaxError(self, "invalid syntax");
     }
+    ctx()->stmt_depth++;  // [iter]
     check(compile_block_body(self));
+    ctx()->stmt_depth--;
     Ctx__emit_jump(ctx(), block_start, BC_KEEPLINE);
     Ctx__exit_block(ctx());
     // optional else clause
@@ -2504,7 +2643,9 @@ static Error* compile_class(Compiler* self, int decorators) {
         if(it->is_compiling_class) return SyntaxError(self, "nested class is not allowed");
     }
     ctx()->is_compiling_class = true;
+    ctx()->stmt_depth++;  // [cls]
     check(compile_block_body(self));
+    ctx()->stmt_depth--;
     ctx()->is_compiling_class = false;
 
     Ctx__s_emit_decorators(ctx(), decorators);
@@ -2666,10 +2807,9 @@ static Error* compile_try_except(Compiler* self) {
     int patches[8];
     int patches_length = 0;
 
+    // the try body is found in `CodeObject.handlers` on errors
     Ctx__enter_block(ctx(), CodeBlockType_TRY);
-    Ctx__emit_(ctx(), OP_BEGIN_TRY, BC_NOARG, prev()->line);
     check(compile_block_body(self));
-    Ctx__emit_(ctx(), OP_END_TRY, BC_NOARG, BC_KEEPLINE);
 
     // https://docs.python.org/3/reference/compound_stmts.html#finally-clause
     /* If finally is present, it specifies a ‘cleanup’ handler. The try clause is executed,
@@ -2711,16 +2851,18 @@ static Error* compile_try_except(Compiler* self) {
             Ctx__emit_(ctx(), OP_LOAD_TRUE, BC_NOARG, BC_KEEPLINE);
         }
         int patch = Ctx__emit_(ctx(), OP_POP_JUMP_IF_FALSE, BC_NOARG, BC_KEEPLINE);
-        // on match
+        // on match, [exc] is kept on the stack until the end of the except clause
         Ctx__emit_(ctx(), OP_HANDLE_EXCEPTION, BC_NOARG, BC_KEEPLINE);
         if(as_name) {
-            Ctx__emit_(ctx(), OP_PUSH_EXCEPTION, BC_NOARG, BC_KEEPLINE);
+            Ctx__emit_(ctx(), OP_DUP_TOP, BC_NOARG, BC_KEEPLINE);
             Ctx__emit_store_name(ctx(), name_scope(self), as_name, BC_KEEPLINE);
         }
         Ctx__enter_block(ctx(), CodeBlockType_EXCEPT);
+        ctx()->stmt_depth++;
         check(compile_block_body(self));
+        ctx()->stmt_depth--;
         Ctx__exit_block(ctx());
-        Ctx__emit_(ctx(), OP_END_TRY, BC_NOARG, BC_KEEPLINE);
+        Ctx__emit_(ctx(), OP_POP_TOP, BC_NOARG, BC_KEEPLINE);
         patches[patches_length++] = Ctx__emit_(ctx(), OP_JUMP_FORWARD, BC_NOARG, BC_KEEPLINE);
         Ctx__patch_jump(ctx(), patch);
     } while(curr()->type == TK_EXCEPT);
@@ -2885,7 +3027,9 @@ static Error* compile_stmt(Compiler* self) {
                 // discard `__enter__()`'s return value
                 Ctx__emit_(ctx(), OP_POP_TOP, BC_NOARG, BC_KEEPLINE);
             }
+            ctx()->stmt_depth++;  // [ <expr> ]
             check(compile_block_body(self));
+            ctx()->stmt_depth--;
             Ctx__emit_(ctx(), OP_WITH_EXIT, BC_NOARG, prev()->line);
             Ctx__exit_block(ctx());
         } break;
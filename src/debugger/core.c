@@ -42,6 +42,7 @@ static struct c11_debugger {
     bool isexceptionmode;
 
     c11_vector* exception_stacktrace;
+    c11_vector* exception_snapshots;
     c11_vector breakpoints;
     c11_vector py_frames;
     c11_smallmap_d2index scopes_query_cache;
@@ -110,6 +111,7 @@ void c11_debugger_exception_on_trace(py_Ref exc) {
     const char* name = py_tpname(exc->type);
     const char* message = safe_stringify_exception(exc);
     debugger.exception_stacktrace = stacktrace;
+    debugger.exception_snapshots = &ud->snapshots;
     debugger.isexceptionmode = true;
     debugger.current_excname = name;
     debugger.current_excmessage = message;
@@ -259,10 +261,11 @@ void c11_debugger_exception_frames(c11_sbuf* buffer) {
     int idx = 0;
     c11__foreach(BaseExceptionFrame, debugger.exception_stacktrace, it) {
         if(idx > 0) c11_sbuf__write_char(buffer, ',');
-        int line = it->lineno;
-        const char* filename = it->src->filename->data;
+        int line = BaseExceptionFrame__lineno(it);
+        const char* filename = BaseExceptionFrame__src(it)->filename->data;
         const char* basename = get_basename(filename);
-        const char* modname = it->name == NULL ? basename : it->name->data;
+        const char* name = BaseExceptionFrame__name(it);
+        const char* modname = name == NULL ? basename : name;
         pk_sprintf(
             buffer,
             "{\"id\": %d, \"name\": %Q, \"line\": %d, \"column\": 1, \"source\": {\"name\": %Q, \"path\": %Q}}",
@@ -295,11 +298,10 @@ inline static c11_debugger_scope_index append_new_scope(int frameid) {
 
 inline static c11_debugger_scope_index append_new_exception_scope(int frameid) {
     assert(frameid < debugger.exception_stacktrace->length);
-    BaseExceptionFrame* requested_frame =
-        c11__at(BaseExceptionFrame, debugger.exception_stacktrace, frameid);
+    py_TValue* snapshot = c11__at(py_TValue, debugger.exception_snapshots, frameid * 2);
     int base_index = py_list_len(python_vars);
-    py_list_append(python_vars, &requested_frame->locals);
-    py_list_append(python_vars, &requested_frame->globals);
+    py_list_append(python_vars, &snapshot[0]);
+    py_list_append(python_vars, &snapshot[1]);
     c11_debugger_scope_index result = {.locals_ref = base_index, .globals_ref = base_index + 1};
     return result;
 }
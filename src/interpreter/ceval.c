@@ -2,35 +2,69 @@
 #include "pocketpy/common/utils.h"
 #include "pocketpy/interpreter/frame.h"
 #include "pocketpy/interpreter/vm.h"
+#include "pocketpy/interpreter/types.h"
 #include "pocketpy/common/sstream.h"
+#include "pocketpy/common/dmath.h"
 #include "pocketpy/objects/codeobject.h"
 #include "pocketpy/objects/exception.h"
+#include "pocketpy/objects/iterator.h"
 #include "pocketpy/pocketpy.h"
 #include "pocketpy/objects/error.h"
 #include <stdbool.h>
 #include <assert.h>
 #include <time.h>
 
+#if PK_ENABLE_COMPUTED_GOTO
+// Threaded code: each handler jumps directly to the next one through `OP_LABELS`.
+// While the VM is instrumented, the second table routes every opcode to `__NEXT_STEP`.
+#define CASE(op)                                                                                   \
+    case op:                                                                                       \
+    __LABEL_##op:
+#define DISPATCH_NEXT()                                                                            \
+    do {                                                                                           \
+        byte = co_codes[frame->ip];                                                                \
+        goto* OP_LABELS[self->is_instrumented][byte.op];                                           \
+    } while(0)
+#else
+#define CASE(op) case op:
+#define DISPATCH_NEXT() goto __NEXT_STEP
+#endif
+
 #define DISPATCH()                                                                                 \
     do {                                                                                           \
         frame->ip++;                                                                               \
-        goto __NEXT_STEP;                                                                          \
+        DISPATCH_NEXT();                                                                           \
     } while(0)
 #define DISPATCH_JUMP(__offset)                                                                    \
     do {                                                                                           \
         frame->ip += __offset;                                                                     \
-        goto __NEXT_STEP;                                                                          \
+        DISPATCH_NEXT();                                                                           \
     } while(0)
 #define DISPATCH_JUMP_ABSOLUTE(__target)                                                           \
     do {                                                                                           \
         frame->ip = __target;                                                                      \
-        goto __NEXT_STEP;                                                                          \
+        DISPATCH_NEXT();                                                                           \
     } while(0)
 
 #define RESET_CO_CACHE()                                                                           \
     do {                                                                                           \
         co_codes = frame->co->codes.data;                                                          \
         co_names = frame->co->names.data;                                                          \
+        co_caches = frame->co->caches;                                                             \
+        if(!co_caches) co_caches = CodeObject__init_caches((CodeObject*)frame->co);                \
+    } while(0)
+
+/* Quickening */
+// A generic instruction is rewritten in place into a specialized form after it has run
+// `ADAPTIVE_WARMUP` times. A specialized form whose guard fails goes back to the generic one.
+#define ADAPTIVE_WARMUP 8
+#define ADAPTIVE_COUNTER() (co_caches[frame->ip].counter)
+#define QUICKEN(__op) (co_codes[frame->ip].op = (__op))
+#define DEOPT(__op)                                                                                \
+    do {                                                                                           \
+        co_codes[frame->ip].op = (__op);                                                           \
+        ADAPTIVE_COUNTER() = 0;                                                                    \
+        DISPATCH_NEXT();                                                                           \
     } while(0)
 
 /* Stack manipulation macros */
@@ -81,25 +115,462 @@ static bool unpack_dict_to_buffer(py_Ref key, py_Ref val, void* ctx) {
     return TypeError("keywords must be strings, not '%t'", key->type);
 }
 
-FrameResult VM__run_top_frame(VM* self) {
+static PK_INLINE void number_setint(py_TValue* out, py_i64 val) {
+    out->type = tp_int;
+    out->is_ptr = false;
+    out->_i64 = val;
+}
+
+// advances an unboxed range iterator, see `pk_newrangecounter()`
+static PK_INLINE bool range_counter_next(py_TValue* it, py_i64* out) {
+    py_i64* counter = (py_i64*)it->_chars;  // {current, stop}
+    py_i64 current = counter[0];
+    py_i64 step = it->extra;
+    if(step > 0 ? current >= counter[1] : current <= counter[1]) return false;
+    counter[0] = current + step;
+    *out = current;
+    return true;
+}
+
+static PK_INLINE void number_setfloat(py_TValue* out, py_f64 val) {
+    out->type = tp_float;
+    out->is_ptr = false;
+    out->_f64 = val;
+}
+
+static PK_INLINE void number_setbool(py_TValue* out, bool val) {
+    out->type = tp_bool;
+    out->is_ptr = false;
+    out->_bool = val;
+}
+
+// Inline fast paths for `int` and `float` operands, writes the result into `lhs`.
+// Returns `false` to fallback to `pk_stack_binaryop`, which is also used for all error cases.
+// They must behave exactly like the magic methods in `py_number.c`.
+static PK_INLINE bool number_binaryop(Opcode op, py_TValue* lhs, py_TValue* rhs) {
+    if(lhs->type == tp_int && rhs->type == tp_int) {
+        py_i64 a = lhs->_i64;
+        py_i64 b = rhs->_i64;
+        switch(op) {
+            case OP_BINARY_ADD: lhs->_i64 = a + b; return true;
+            case OP_BINARY_SUB: lhs->_i64 = a - b; return true;
+            case OP_BINARY_MUL: lhs->_i64 = a * b; return true;
+            case OP_BINARY_TRUEDIV:
+                if(b == 0) return false;
+                number_setfloat(lhs, a / (py_f64)b);
+                return true;
+            case OP_BINARY_FLOORDIV:
+                if(b == 0) return false;
+                lhs->_i64 = cpy312__int_floordiv(a, b);
+                return true;
+            case OP_BINARY_MOD:
+                if(b == 0) return false;
+                lhs->_i64 = cpy312__int_mod(a, b);
+                return true;
+            case OP_BINARY_POW: {
+                if(b < 0) return false;
+                py_i64 ret = 1;
+                while(true) {
+                    if(b & 1) ret *= a;
+                    b >>= 1;
+                    if(!b) break;
+                    a *= a;
+                }
+                lhs->_i64 = ret;
+                return true;
+            }
+            case OP_BINARY_LSHIFT: lhs->_i64 = a << b; return true;
+            case OP_BINARY_RSHIFT: lhs->_i64 = a >> b; return true;
+            case OP_BINARY_AND: lhs->_i64 = a & b; return true;
+            case OP_BINARY_OR: lhs->_i64 = a | b; return true;
+            case OP_BINARY_XOR: lhs->_i64 = a ^ b; return true;
+            case OP_COMPARE_LT: number_setbool(lhs, a < b); return true;
+            case OP_COMPARE_LE: number_setbool(lhs, a <= b); return true;
+            case OP_COMPARE_EQ: number_setbool(lhs, a == b); return true;
+            case OP_COMPARE_NE: number_setbool(lhs, a != b); return true;
+            case OP_COMPARE_GT: number_setbool(lhs, a > b); return true;
+            case OP_COMPARE_GE: number_setbool(lhs, a >= b); return true;
+            default: return false;
+        }
+    }
+
+    py_f64 a, b;
+    switch(lhs->type) {
+        case tp_int: a = (py_f64)lhs->_i64; break;
+        case tp_float: a = lhs->_f64; break;
+        default: return false;
+    }
+    switch(rhs->type) {
+        case tp_int: b = (py_f64)rhs->_i64; break;
+        case tp_float: b = rhs->_f64; break;
+        default: return false;
+    }
+    switch(op) {
+        case OP_BINARY_ADD: number_setfloat(lhs, a + b); return true;
+        case OP_BINARY_SUB: number_setfloat(lhs, a - b); return true;
+        case OP_BINARY_MUL: number_setfloat(lhs, a * b); return true;
+        case OP_BINARY_TRUEDIV:
+            if(b == 0.0) return false;
+            number_setfloat(lhs, a / b);
+            return true;
+        case OP_BINARY_FLOORDIV:
+        case OP_BINARY_MOD: {
+            if(b == 0.0) return false;
+            py_f64 q, r;
+            cpy312__float_divmod(a, b, &q, &r);
+            number_setfloat(lhs, op == OP_BINARY_FLOORDIV ? q : r);
+            return true;
+        }
+        case OP_BINARY_POW: number_setfloat(lhs, dmath_pow(a, b)); return true;
+        case OP_COMPARE_LT: number_setbool(lhs, a < b); return true;
+        case OP_COMPARE_LE: number_setbool(lhs, a <= b); return true;
+        case OP_COMPARE_EQ: number_setbool(lhs, a == b); return true;
+        case OP_COMPARE_NE: number_setbool(lhs, a != b); return true;
+        case OP_COMPARE_GT: number_setbool(lhs, a > b); return true;
+        case OP_COMPARE_GE: number_setbool(lhs, a >= b); return true;
+        default: return false;
+    }
+}
+
+/* Attribute inline caches */
+// An entry remembers what `pk_tpfindname` found for one call site, keyed by the type version.
+// Any change to the `__dict__` of the type or one of its bases resets the version.
+enum AttrCacheKind {
+    AttrCache_EMPTY = 0,
+    AttrCache_DICT,      // no class attribute, look in instance `__dict__`
+    AttrCache_METHOD,    // function or nativefunc
+    AttrCache_CLASSVAR,  // class attribute without descriptor behavior
+    AttrCache_PROPERTY,
+    AttrCache_MEMBER,    // `__slots__` member, `index` is the slot
+};
+
+static void attrcache_fill(InlineCache* ic, py_Ref self, py_Name name, bool is_store) {
+    py_TypeInfo* ti = pk_typeinfo(self->type);
+    ic->kind = AttrCache_EMPTY;
+    if(self->type == tp_type) return;
+    if(is_store ? ti->setattribute != NULL : ti->getattribute != NULL) return;
+    py_Ref cls_var = pk_tpfindname(ti, name);
+    int kind;
+    if(cls_var == NULL) {
+        kind = AttrCache_DICT;
+    } else {
+        switch(cls_var->type) {
+            case tp_property: kind = AttrCache_PROPERTY; break;
+            case tp_member_descriptor: kind = AttrCache_MEMBER; break;
+            case tp_function:
+            case tp_nativefunc: kind = name == __new__ ? AttrCache_CLASSVAR : AttrCache_METHOD; break;
+            case tp_staticmethod:
+            case tp_classmethod: return;
+            default: kind = AttrCache_CLASSVAR; break;
+        }
+        // only `__dict__`, members and property setters have fast paths for stores
+        if(is_store && kind != AttrCache_PROPERTY && kind != AttrCache_MEMBER) {
+            kind = AttrCache_DICT;
+        }
+    }
+    ic->version = py_TypeInfo__version(ti);
+    ic->kind = kind;
+    if(kind == AttrCache_DICT) {
+        ic->shape = NULL;  // filled by the first access
+    } else if(kind == AttrCache_MEMBER) {
+        ic->index = cls_var->extra;
+    } else {
+        ic->value = cls_var;
+    }
+}
+
+// same as `py_getattr` for a cached site, returns -1 on error or 0 if the slow path is needed
+static PK_INLINE int attrcache_getattr(InlineCache* ic, py_Ref self, py_Name name) {
+    if(ic->kind == AttrCache_EMPTY) return 0;
+    if(pk_typeinfo(self->type)->version != ic->version) return 0;
+    if(ic->kind == AttrCache_PROPERTY) {
+        py_Ref getter = py_getslot(ic->value, 0);
+        return py_call(getter, 1, self) ? 1 : -1;
+    }
+    if(ic->kind == AttrCache_MEMBER) {
+        // unset or foreign slots take the slow path for the error
+        if(!self->is_ptr || ic->index >= self->_obj->slots) return 0;
+        py_Ref slot = PyObject__slots_raw(self->_obj) + ic->index;
+        if(py_isnil(slot)) return 0;
+        py_assign(py_retval(), slot);
+        return 1;
+    }
+    if(self->is_ptr && self->_obj->slots == -1) {
+        NameDict* dict = PyObject__dict_raw(self->_obj);
+        if(ic->kind == AttrCache_DICT && NameDict__is_shaped(dict)) {
+            if(dict->shape != ic->shape) {
+                int index = InstanceShape__index(dict->shape, name);
+                if(index < 0) return 0;
+                ic->shape = dict->shape;
+                ic->index = index;
+            }
+            py_assign(py_retval(), &dict->values[ic->index]);
+            return 1;
+        }
+        py_Ref res = NameDict__try_get(dict, name);
+        if(res) {
+            py_assign(py_retval(), res);
+            return 1;
+        }
+    }
+    switch(ic->kind) {
+        case AttrCache_METHOD: py_newboundmethod(py_retval(), self, ic->value); return 1;
+        case AttrCache_CLASSVAR: py_assign(py_retval(), ic->value); return 1;
+        default: return 0;
+    }
+}
+
+// same as `py_setattr` for a cached site, returns -1 on error or 0 if the slow path is needed
+static PK_INLINE int attrcache_setattr(InlineCache* ic, py_Ref self, py_Name name, py_Ref val) {
+    if(ic->kind == AttrCache_EMPTY) return 0;
+    if(pk_typeinfo(self->type)->version != ic->version) return 0;
+    if(ic->kind == AttrCache_PROPERTY) {
+        py_Ref setter = py_getslot(ic->value, 1);
+        if(py_isnone(setter)) return 0;
+        py_push(setter);
+        py_push(self);
+        py_push(val);
+        return py_vectorcall(1, 0) ? 1 : -1;
+    }
+    if(ic->kind == AttrCache_MEMBER) {
+        if(!self->is_ptr || ic->index >= self->_obj->slots) return 0;
+        PyObject__slots(self->_obj)[ic->index] = *val;
+        return 1;
+    }
+    if(self->is_ptr && self->_obj->slots == -1) {
+        NameDict* dict = PyObject__dict(self->_obj);
+        if(NameDict__is_shaped(dict)) {
+            InstanceShape* shape = ic->shape;
+            if(dict->shape == shape) {
+                dict->values[ic->index] = *val;
+                return 1;
+            }
+            // adding the key moves the instance to the cached shape
+            if(shape && dict->shape == shape->parent && ic->index == dict->length &&
+               dict->length < dict->capacity) {
+                dict->values[dict->length++] = *val;
+                dict->shape = shape;
+                return 1;
+            }
+            NameDict__set(dict, name, val);
+            if(NameDict__is_shaped(dict)) {
+                ic->shape = dict->shape;
+                ic->index = InstanceShape__index(dict->shape, name);
+            }
+            return 1;
+        }
+        py_setdict(self, name, val);
+        return 1;
+    }
+    return 0;
+}
+
+// same conditions as `pk_loadmethod` returning [function, self]
+static void methodcache_fill(InlineCache* ic, py_Ref self, py_Name name) {
+    ic->kind = AttrCache_EMPTY;
+    if(name == __new__ || self->type == tp_super) return;
+    py_TypeInfo* ti = pk_typeinfo(self->type);
+    if(ti->getunboundmethod) return;
+    py_Ref cls_var = pk_tpfindname(ti, name);
+    if(cls_var && (cls_var->type == tp_function || cls_var->type == tp_nativefunc)) {
+        ic->version = py_TypeInfo__version(ti);
+        ic->kind = AttrCache_METHOD;
+        ic->value = cls_var;
+    }
+}
+
+static bool load_attr(InlineCache* ic, py_Ref self, py_Name name) {
+    int res = attrcache_getattr(ic, self, name);
+    if(res != 0) return res == 1;
+    attrcache_fill(ic, self, name, false);
+    return py_getattr(self, name);
+}
+
+static bool store_attr(InlineCache* ic, py_Ref self, py_Name name, py_Ref val) {
+    int res = attrcache_setattr(ic, self, name, val);
+    if(res != 0) return res == 1;
+    attrcache_fill(ic, self, name, true);
+    return py_setattr(self, name, val);
+}
+
+/* Global inline caches */
+// An entry is valid as long as neither the module nor `builtins` has been modified since
+// it was filled. Module versions are unique per VM, so they also identify the module.
+#define MODULE_VERSION(module) (((py_ModuleInfo*)PyObject__userdata_raw((module)->_obj))->version)
+
+static PK_INLINE py_Ref globalcache_get(VM* self, InlineCache* ic, py_Frame* frame) {
+    if(frame->globals->type != tp_module) return NULL;
+    if(MODULE_VERSION(frame->globals) != ic->globals_version) return NULL;
+    if(MODULE_VERSION(self->builtins) != ic->builtins_version) return NULL;
+    return ic->value;
+}
+
+static py_Ref globalcache_fill(VM* self, InlineCache* ic, py_Frame* frame, py_Name name) {
+    if(frame->globals->type != tp_module) return NULL;
+    py_Ref res = py_getdict(frame->globals, name);
+    if(res == NULL) res = py_getdict(self->builtins, name);
+    if(res == NULL) return NULL;
+    ic->globals_version = MODULE_VERSION(frame->globals);
+    ic->builtins_version = MODULE_VERSION(self->builtins);
+    ic->value = res;
+    return res;
+}
+
+static bool stack_compareop(VM* self, Opcode op) {
+    switch(op) {
+        case OP_COMPARE_LT: return pk_stack_binaryop(self, __lt__, __gt__);
+        case OP_COMPARE_LE: return pk_stack_binaryop(self, __le__, __ge__);
+        case OP_COMPARE_EQ: return pk_stack_binaryop(self, __eq__, __eq__);
+        case OP_COMPARE_NE: return pk_stack_binaryop(self, __ne__, __ne__);
+        case OP_COMPARE_GT: return pk_stack_binaryop(self, __gt__, __lt__);
+        case OP_COMPARE_GE: return pk_stack_binaryop(self, __ge__, __le__);
+        default: c11__unreachable();
+    }
+}
+
+#if PK_ENABLE_WATCHDOG
+// only called every `PK_WATCHDOG_POLL_INTERVAL` polls, so the clock read stays off the hot path
+static bool watchdog_expired(VM* self) {
+    WatchdogInfo* info = &self->watchdog_info;
+    info->countdown = PK_WATCHDOG_POLL_INTERVAL;
+    if(py_debugger_status() != 0) return false;
+    return time_monotonic_ns() > info->deadline;
+}
+
+// polled at loop back-edges and function entry
+#define WATCHDOG_POLL()                                                                            \
+    if(self->watchdog_info.deadline > 0 && --self->watchdog_info.countdown <= 0 &&                 \
+       watchdog_expired(self)) {                                                                   \
+        py_watchdog_end();                                                                         \
+        TimeoutError("watchdog timeout");                                                          \
+        goto __ERROR;                                                                              \
+    }
+#else
+#define WATCHDOG_POLL()
+#endif
+
+static Opcode specialize_for_iter(py_Ref iter) {
+    switch(iter->type) {
+        case tp_list_iterator: return OP_FOR_ITER_LIST;
+        case tp_tuple_iterator: return OP_FOR_ITER_TUPLE;
+        case tp_range_iterator: return OP_FOR_ITER_RANGE;
+        default: return OP_FOR_ITER;
+    }
+}
+
+// [callable, <self>, args...] of a simple python function whose positional args match exactly
+static bool is_py_exact_args_call(py_StackRef p0, py_StackRef sp) {
+    if(p0->type != tp_function) return false;
+    Function* fn = PyObject__userdata_raw(p0->_obj);
+    if(fn->decl->type != FuncType_SIMPLE || fn->cfunc) return false;
+    py_StackRef argv = p0 + 1 + (int)py_isnil(p0 + 1);
+    return sp - argv == fn->decl->args.length;
+}
+
+// Fill the plan of a call site to a python function with keyword parameters.
+// Calls that need `*args`, `**kwargs` or raise a `TypeError` are left to `prepare_py_call`.
+static bool callplan_fill(VM* self, InlineCache* ic, py_StackRef p0, py_StackRef p1, int kwargc) {
+    if(p0->type != tp_function) return false;
+    Function* fn = PyObject__userdata_raw(p0->_obj);
+    FuncDecl* decl = fn->decl;
+    if(decl->type != FuncType_NORMAL || fn->cfunc) return false;
+    if(decl->starred_arg != -1 || decl->starred_kwarg != -1) return false;
+
+    int nargs = decl->args.length;
+    int nparams = nargs + decl->kwargs.length;
+    for(int i = 0; i < nargs; i++) {
+        if(c11__getitem(int, &decl->args, i) != i) return false;
+    }
+    for(int i = nargs; i < nparams; i++) {
+        if(c11__at(FuncDeclKwArg, &decl->kwargs, i - nargs)->index != i) return false;
+    }
+
+    py_StackRef argv = p0 + 1 + (int)py_isnil(p0 + 1);
+    int argc = p1 - argv;
+    if(argc < nargs || argc > nparams) return false;
+
+    if(ic->plan == NULL) ic->plan = PK_MALLOC(sizeof(CallPlan) + kwargc * sizeof(int16_t));
+    CallPlan* plan = ic->plan;
+    for(int j = 0; j < kwargc; j++) {
+        py_Name key = (py_Name)py_toint(&p1[2 * j]);
+        int index = c11_smallmap_n2d__get(&decl->kw_to_index, key, -1);
+        if(index < 0) return false;
+        plan->kw_index[j] = index;
+    }
+    if(decl->uid == 0) decl->uid = ++self->next_decl_uid;
+    plan->decl_uid = decl->uid;
+    plan->argc = argc;
+    plan->nparams = nparams;
+    return true;
+}
+
+#if PK_ENABLE_COMPUTED_GOTO
+enum {
+    OPCODE_COUNT = 0
+#define OPCODE(name) +1
+#include "pocketpy/xmacros/opcodes.h"
+#undef OPCODE
+};
+#endif
+
+static FrameResult VM__dispatch(VM* self, const py_Frame* base_frame);
+
+FrameResult VM__run_top_frame(VM* self) { return VM__run_frames(self, self->top_frame); }
+
+FrameResult VM__run_frames(VM* self, const py_Frame* base_frame) {
+    // a nested run means a C function is calling into python, see `ManagedHeap__can_promote()`
+    self->heap.run_depth++;
+    FrameResult res = VM__dispatch(self, base_frame);
+    self->heap.run_depth--;
+    return res;
+}
+
+static FrameResult VM__dispatch(VM* self, const py_Frame* base_frame) {
     py_Frame* frame = self->top_frame;
     Bytecode* co_codes;
     py_Name* co_names;
+    InlineCache* co_caches;
     Bytecode byte;
 
-    const py_Frame* base_frame = frame;
+#if PK_ENABLE_COMPUTED_GOTO
+    static const void* const OP_LABELS[2][OPCODE_COUNT] = {
+        {
+    #define OPCODE(name) &&__LABEL_OP_##name,
+    #include "pocketpy/xmacros/opcodes.h"
+    #undef OPCODE
+        },
+        {
+    #define OPCODE(name) &&__NEXT_STEP,
+    #include "pocketpy/xmacros/opcodes.h"
+    #undef OPCODE
+        },
+    };
+#endif
 
 __NEXT_FRAME:
     if(self->recursion_depth >= self->max_recursion_depth) {
         py_exception(tp_RecursionError, "maximum recursion depth exceeded");
         goto __ERROR;
     }
+    WATCHDOG_POLL();
     RESET_CO_CACHE();
     frame->ip++;
 
 __NEXT_STEP:
     byte = co_codes[frame->ip];
 
+    if(!self->is_instrumented) goto __DISPATCH_STEP;
+
+    if(self->budget_info.base_frame && --self->budget_info.remaining < 0) {
+        // only frames of the task itself can be detached, not those under a native call;
+        // the VM also holds state of a pending exception or a class body being defined
+        if(base_frame == self->budget_info.base_frame && py_isnil(&self->unhandled_exc) &&
+           !self->curr_class) {
+            frame->ip--;  // resume at this instruction
+            return RES_SUSPEND;
+        }
+    }
+
     if(self->trace_info.func) {
         bool is_virtual = byte.op == OP_RETURN_VALUE && byte.arg == BC_RETURN_VIRTUAL;
         if(!is_virtual) {
@@ -114,37 +585,28 @@ __NEXT_STEP:
         }
     }
 
-#if PK_ENABLE_WATCHDOG
-    if(self->watchdog_info.max_reset_time > 0) {
-        if(py_debugger_status() == 0 && clock() > self->watchdog_info.max_reset_time) {
-            self->watchdog_info.max_reset_time = 0;
-            TimeoutError("watchdog timeout");
-            goto __ERROR;
-        }
-    }
-#endif
-
+__DISPATCH_STEP:
 #ifndef NDEBUG
     pk_print_stack(self, frame, byte);
 #endif
 
     switch((Opcode)byte.op) {
-        case OP_NO_OP: DISPATCH();
+        CASE(OP_NO_OP) DISPATCH();
         /*****************************************/
-        case OP_POP_TOP: POP(); DISPATCH();
-        case OP_DUP_TOP: PUSH(TOP()); DISPATCH();
-        case OP_DUP_TOP_TWO:
+        CASE(OP_POP_TOP) POP(); DISPATCH();
+        CASE(OP_DUP_TOP) PUSH(TOP()); DISPATCH();
+        CASE(OP_DUP_TOP_TWO)
             // [a, b]
             PUSH(SECOND());  // [a, b, a]
             PUSH(SECOND());  // [a, b, a, b]
             DISPATCH();
-        case OP_ROT_TWO: {
+        CASE(OP_ROT_TWO) {
             py_TValue tmp = *TOP();
             *TOP() = *SECOND();
             *SECOND() = tmp;
             DISPATCH();
         }
-        case OP_ROT_THREE: {
+        CASE(OP_ROT_THREE) {
             // [a, b, c] -> [c, a, b]
             py_TValue tmp = *TOP();
             *TOP() = *SECOND();
@@ -152,7 +614,7 @@ __NEXT_STEP:
             *THIRD() = tmp;
             DISPATCH();
         }
-        case OP_PRINT_EXPR: {
+        CASE(OP_PRINT_EXPR) {
             if(self->callbacks.displayhook) {
                 bool ok = self->callbacks.displayhook(TOP());
                 if(!ok) goto __ERROR;
@@ -168,61 +630,77 @@ __NEXT_STEP:
             DISPATCH();
         }
         /*****************************************/
-        case OP_LOAD_CONST: {
+        CASE(OP_LOAD_CONST) {
             PUSH(c11__at(py_TValue, &frame->co->consts, byte.arg));
             DISPATCH();
         }
-        case OP_LOAD_NONE: {
+        CASE(OP_LOAD_NONE) {
             py_newnone(SP()++);
             DISPATCH();
         }
-        case OP_LOAD_TRUE: {
+        CASE(OP_LOAD_TRUE) {
             py_newbool(SP()++, true);
             DISPATCH();
         }
-        case OP_LOAD_FALSE: {
+        CASE(OP_LOAD_FALSE) {
             py_newbool(SP()++, false);
             DISPATCH();
         }
         /*****************************************/
-        case OP_LOAD_SMALL_INT: {
+        CASE(OP_LOAD_SMALL_INT) {
             py_newint(SP()++, (int16_t)byte.arg);
             DISPATCH();
         }
-        case OP_LOAD_NAME_AS_INT: {
+        CASE(OP_LOAD_NAME_AS_INT) {
             py_Name name = co_names[byte.arg];
             py_newint(SP()++, (uintptr_t)name);
             DISPATCH();
         }
         /*****************************************/
-        case OP_LOAD_ELLIPSIS: {
+        CASE(OP_LOAD_ELLIPSIS) {
             py_newellipsis(SP()++);
             DISPATCH();
         }
-        case OP_LOAD_FUNCTION: {
+        CASE(OP_LOAD_FUNCTION) {
             FuncDecl_ decl = c11__getitem(FuncDecl_, &frame->co->func_decls, byte.arg);
-            Function* ud = py_newobject(SP(), tp_function, 0, sizeof(Function));
+            int n_captures = decl->captures.length;
+            // captured values are stored right after `Function`
+            Function* ud = py_newobject(SP(),
+                                        tp_function,
+                                        0,
+                                        sizeof(Function) + sizeof(py_TValue) * n_captures);
             Function__ctor(ud, decl, frame->module, frame->globals);
             if(decl->nested) {
                 if(frame->is_locals_special) {
                     RuntimeError("cannot create closure from special locals");
                     goto __ERROR;
                 }
-                ud->closure = FastLocals__to_namedict(frame->locals, frame->co);
-                py_Name name = py_name(decl->code.name->data);
-                // capture itself to allow recursion
-                NameDict__set(ud->closure, name, SP());
+                if(n_captures > 0) ud->closure = (py_TValue*)(ud + 1);
+                for(int i = 0; i < n_captures; i++) {
+                    FuncDeclCapture* capture = c11__at(FuncDeclCapture, &decl->captures, i);
+                    py_TValue* slot = &ud->closure[i];
+                    switch(capture->kind) {
+                        case CAPTURE_LOCAL: *slot = frame->locals[capture->index]; break;
+                        case CAPTURE_FREE: {
+                            Function* outer = PyObject__userdata_raw(frame->p0->_obj);
+                            *slot = outer->closure ? outer->closure[capture->index] : *py_NIL();
+                            break;
+                        }
+                        case CAPTURE_SELF: *slot = *SP(); break;
+                        default: py_newnil(slot); break;
+                    }
+                }
             } else {
                 if(self->curr_class) ud->clazz = self->curr_class->_obj;
             }
             SP()++;
             DISPATCH();
         }
-        case OP_LOAD_NULL:
+        CASE(OP_LOAD_NULL)
             py_newnil(SP()++);
             DISPATCH();
             /*****************************************/
-        case OP_LOAD_FAST: {
+        CASE(OP_LOAD_FAST) {
             assert(!frame->is_locals_special);
             py_Ref val = &frame->locals[byte.arg];
             if(!py_isnil(val)) {
@@ -233,7 +711,37 @@ __NEXT_STEP:
             UnboundLocalError(name);
             goto __ERROR;
         }
-        case OP_LOAD_NAME: {
+        CASE(OP_LOAD_FAST_LOAD_FAST) {
+            assert(!frame->is_locals_special);
+            py_Ref val = &frame->locals[byte.arg];
+            if(py_isnil(val)) goto __UNBOUND_FAST;
+            PUSH(val);
+            byte = co_codes[++frame->ip];
+            val = &frame->locals[byte.arg];
+            if(py_isnil(val)) goto __UNBOUND_FAST;
+            PUSH(val);
+            DISPATCH();
+        }
+        CASE(OP_LOAD_FAST_LOAD_CONST) {
+            assert(!frame->is_locals_special);
+            py_Ref val = &frame->locals[byte.arg];
+            if(py_isnil(val)) goto __UNBOUND_FAST;
+            PUSH(val);
+            byte = co_codes[++frame->ip];
+            PUSH(c11__at(py_TValue, &frame->co->consts, byte.arg));
+            DISPATCH();
+        }
+        CASE(OP_LOAD_FAST_LOAD_ATTR) {
+            assert(!frame->is_locals_special);
+            py_Ref val = &frame->locals[byte.arg];
+            if(py_isnil(val)) goto __UNBOUND_FAST;
+            PUSH(val);
+            byte = co_codes[++frame->ip];
+            if(!load_attr(co_caches + frame->ip, TOP(), co_names[byte.arg])) goto __ERROR;
+            py_assign(TOP(), py_retval());
+            DISPATCH();
+        }
+        CASE(OP_LOAD_NAME) {
             assert(frame->is_locals_special);
             py_Name name = co_names[byte.arg];
             // locals
@@ -263,6 +771,13 @@ __NEXT_STEP:
                 default: c11__unreachable();
             }
             // globals
+            InlineCache* ic = co_caches + frame->ip;
+            py_Ref tmp = globalcache_get(self, ic, frame);
+            if(!tmp) tmp = globalcache_fill(self, ic, frame, name);
+            if(tmp) {
+                PUSH(tmp);
+                DISPATCH();
+            }
             int res = Frame__getglobal(frame, name);
             if(res == 1) {
                 PUSH(&self->last_retval);
@@ -270,7 +785,7 @@ __NEXT_STEP:
             }
             if(res == -1) goto __ERROR;
             // builtins
-            py_Ref tmp = py_getdict(self->builtins, name);
+            tmp = py_getdict(self->builtins, name);
             if(tmp != NULL) {
                 PUSH(tmp);
                 DISPATCH();
@@ -278,13 +793,15 @@ __NEXT_STEP:
             NameError(name);
             goto __ERROR;
         }
-        case OP_LOAD_NONLOCAL: {
-            py_Name name = co_names[byte.arg];
-            py_Ref tmp = Frame__getclosure(frame, name);
-            if(tmp != NULL) {
+        CASE(OP_LOAD_DEREF) {
+            Function* ud = PyObject__userdata_raw(frame->p0->_obj);
+            py_Ref tmp = &ud->closure[byte.arg];
+            if(!py_isnil(tmp)) {
                 PUSH(tmp);
                 DISPATCH();
             }
+            // not bound in the enclosing frame when the function was created
+            py_Name name = c11__getitem(py_Name, &frame->co->freevars, byte.arg);
             int res = Frame__getglobal(frame, name);
             if(res == 1) {
                 PUSH(&self->last_retval);
@@ -300,15 +817,22 @@ __NEXT_STEP:
             NameError(name);
             goto __ERROR;
         }
-        case OP_LOAD_GLOBAL: {
+        CASE(OP_LOAD_GLOBAL) {
             py_Name name = co_names[byte.arg];
+            InlineCache* ic = co_caches + frame->ip;
+            py_Ref tmp = globalcache_get(self, ic, frame);
+            if(!tmp) tmp = globalcache_fill(self, ic, frame, name);
+            if(tmp) {
+                PUSH(tmp);
+                DISPATCH();
+            }
             int res = Frame__getglobal(frame, name);
             if(res == 1) {
                 PUSH(&self->last_retval);
                 DISPATCH();
             }
             if(res == -1) goto __ERROR;
-            py_Ref tmp = py_getdict(self->builtins, name);
+            tmp = py_getdict(self->builtins, name);
             if(tmp != NULL) {
                 PUSH(tmp);
                 DISPATCH();
@@ -316,22 +840,22 @@ __NEXT_STEP:
             NameError(name);
             goto __ERROR;
         }
-        case OP_LOAD_ATTR: {
+        CASE(OP_LOAD_ATTR) {
             py_Name name = co_names[byte.arg];
-            if(py_getattr(TOP(), name)) {
+            if(load_attr(co_caches + frame->ip, TOP(), name)) {
                 py_assign(TOP(), py_retval());
             } else {
                 goto __ERROR;
             }
             DISPATCH();
         }
-        case OP_LOAD_SELF_ATTR: {
+        CASE(OP_LOAD_SELF_ATTR) {
             assert(!frame->is_locals_special);
             py_Ref val = &frame->locals[0];
             if(!py_isnil(val)) {
                 // LOAD_ATTR
                 py_Name name = co_names[byte.arg];
-                if(py_getattr(val, name)) {
+                if(load_attr(co_caches + frame->ip, val, name)) {
                     PUSH(py_retval());
                 } else {
                     goto __ERROR;
@@ -342,7 +866,7 @@ __NEXT_STEP:
             UnboundLocalError(name);
             goto __ERROR;
         }
-        case OP_LOAD_CLASS_GLOBAL: {
+        CASE(OP_LOAD_CLASS_GLOBAL) {
             assert(self->curr_class);
             py_Name name = co_names[byte.arg];
             py_Ref tmp = py_getdict(self->curr_class, name);
@@ -365,13 +889,31 @@ __NEXT_STEP:
             NameError(name);
             goto __ERROR;
         }
-        case OP_LOAD_METHOD: {
+        CASE(OP_LOAD_METHOD) {
             // [self] -> [unbound, self]
             py_Name name = co_names[byte.arg];
+            InlineCache* ic = co_caches + frame->ip;
+            if(ic->kind == AttrCache_METHOD) {
+                if(pk_typeinfo(TOP()->type)->version == ic->version) {
+                    *SP() = *TOP();
+                    *TOP() = *ic->value;
+                    SP()++;
+                    DISPATCH();
+                }
+            } else {
+                int res = attrcache_getattr(ic, TOP(), name);
+                if(res == -1) goto __ERROR;
+                if(res == 1) {
+                    py_assign(TOP(), py_retval());
+                    py_newnil(SP()++);
+                    DISPATCH();
+                }
+            }
+            methodcache_fill(ic, TOP(), name);
             bool ok = py_pushmethod(name);
             if(!ok) {
                 // fallback to getattr
-                if(py_getattr(TOP(), name)) {
+                if(load_attr(ic, TOP(), name)) {
                     py_assign(TOP(), py_retval());
                     py_newnil(SP()++);
                 } else {
@@ -380,8 +922,14 @@ __NEXT_STEP:
             }
             DISPATCH();
         }
-        case OP_LOAD_SUBSCR: {
+        CASE(OP_LOAD_SUBSCR) {
             // [a, b] -> a[b]
+            if(++ADAPTIVE_COUNTER() >= ADAPTIVE_WARMUP) {
+                ADAPTIVE_COUNTER() = 0;
+                if(SECOND()->type == tp_list && TOP()->type == tp_int) {
+                    QUICKEN(OP_LOAD_SUBSCR_LIST_INT);
+                }
+            }
             py_Ref magic = py_tpfindmagic(SECOND()->type, __getitem__);
             if(magic) {
                 if(magic->type == tp_nativefunc) {
@@ -398,12 +946,21 @@ __NEXT_STEP:
             TypeError("'%t' object is not subscriptable", SECOND()->type);
             goto __ERROR;
         }
-        case OP_STORE_FAST: {
+        CASE(OP_LOAD_SUBSCR_LIST_INT) {
+            if(SECOND()->type != tp_list || TOP()->type != tp_int) DEOPT(OP_LOAD_SUBSCR);
+            List* list = PyObject__userdata_raw(SECOND()->_obj);
+            int index = TOP()->_i64;
+            if(!pk__normalize_index(&index, list->length)) goto __ERROR;
+            *SECOND() = c11__getitem(py_TValue, list, index);
+            POP();
+            DISPATCH();
+        }
+        CASE(OP_STORE_FAST) {
             assert(!frame->is_locals_special);
             frame->locals[byte.arg] = POPX();
             DISPATCH();
         }
-        case OP_STORE_NAME: {
+        CASE(OP_STORE_NAME) {
             assert(frame->is_locals_special);
             py_Name name = co_names[byte.arg];
             switch(frame->locals->type) {
@@ -431,26 +988,26 @@ __NEXT_STEP:
                 default: c11__unreachable();
             }
         }
-        case OP_STORE_GLOBAL: {
+        CASE(OP_STORE_GLOBAL) {
             py_Name name = co_names[byte.arg];
             if(!Frame__setglobal(frame, name, TOP())) goto __ERROR;
             POP();
             DISPATCH();
         }
-        case OP_STORE_ATTR: {
+        CASE(OP_STORE_ATTR) {
             // [val, a] -> a.b = val
             py_Name name = co_names[byte.arg];
-            if(!py_setattr(TOP(), name, SECOND())) goto __ERROR;
+            if(!store_attr(co_caches + frame->ip, TOP(), name, SECOND())) goto __ERROR;
             STACK_SHRINK(2);
             DISPATCH();
         }
-        case OP_STORE_SELF_ATTR: {
+        CASE(OP_STORE_SELF_ATTR) {
             assert(!frame->is_locals_special);
             py_Ref val = &frame->locals[0];
             if(!py_isnil(val)) {
                 // [val, a] -> a.b = val
                 py_Name name = co_names[byte.arg];
-                if(!py_setattr(val, name, TOP())) goto __ERROR;
+                if(!store_attr(co_caches + frame->ip, val, name, TOP())) goto __ERROR;
                 POP();
                 DISPATCH();
             }
@@ -458,7 +1015,7 @@ __NEXT_STEP:
             UnboundLocalError(name);
             goto __ERROR;
         }
-        case OP_STORE_SUBSCR: {
+        CASE(OP_STORE_SUBSCR) {
             // [val, a, b] -> a[b] = val
             py_Ref magic = py_tpfindmagic(SECOND()->type, __setitem__);
             if(magic) {
@@ -475,7 +1032,7 @@ __NEXT_STEP:
             TypeError("'%t' object does not support item assignment", SECOND()->type);
             goto __ERROR;
         }
-        case OP_DELETE_FAST: {
+        CASE(OP_DELETE_FAST) {
             assert(!frame->is_locals_special);
             py_Ref tmp = &frame->locals[byte.arg];
             if(py_isnil(tmp)) {
@@ -486,7 +1043,7 @@ __NEXT_STEP:
             py_newnil(tmp);
             DISPATCH();
         }
-        case OP_DELETE_NAME: {
+        CASE(OP_DELETE_NAME) {
             assert(frame->is_locals_special);
             py_Name name = co_names[byte.arg];
             switch(frame->locals->type) {
@@ -516,7 +1073,7 @@ __NEXT_STEP:
                 default: c11__unreachable();
             }
         }
-        case OP_DELETE_GLOBAL: {
+        CASE(OP_DELETE_GLOBAL) {
             py_Name name = co_names[byte.arg];
             int res = Frame__delglobal(frame, name);
             if(res == 1) DISPATCH();
@@ -525,13 +1082,13 @@ __NEXT_STEP:
             goto __ERROR;
         }
 
-        case OP_DELETE_ATTR: {
+        CASE(OP_DELETE_ATTR) {
             py_Name name = co_names[byte.arg];
             if(!py_delattr(TOP(), name)) goto __ERROR;
             DISPATCH();
         }
 
-        case OP_DELETE_SUBSCR: {
+        CASE(OP_DELETE_SUBSCR) {
             // [a, b] -> del a[b]
             py_Ref magic = py_tpfindmagic(SECOND()->type, __delitem__);
             if(magic) {
@@ -549,7 +1106,7 @@ __NEXT_STEP:
             goto __ERROR;
         }
         /*****************************************/
-        case OP_BUILD_IMAG: {
+        CASE(OP_BUILD_IMAG) {
             // [x]
             py_Ref f = py_getdict(self->builtins, py_name("complex"));
             assert(f != NULL);
@@ -561,7 +1118,7 @@ __NEXT_STEP:
             vectorcall_opcall(2, 0);
             DISPATCH();
         }
-        case OP_BUILD_BYTES: {
+        CASE(OP_BUILD_BYTES) {
             int size;
             py_Ref string = c11__at(py_TValue, &frame->co->consts, byte.arg);
             const char* data = py_tostrn(string, &size);
@@ -569,7 +1126,7 @@ __NEXT_STEP:
             memcpy(p, data, size);
             DISPATCH();
         }
-        case OP_BUILD_TUPLE: {
+        CASE(OP_BUILD_TUPLE) {
             bool need_track = false;
             py_TValue tmp;
             py_Ref p = py_newtuple(&tmp, byte.arg);
@@ -578,12 +1135,12 @@ __NEXT_STEP:
                 p[i] = begin[i];
                 if(p[i].is_ptr) need_track = true;
             }
-            if(!need_track) tmp._obj->gc_marked |= 0b10;
+            if(!need_track) tmp._obj->gc_marked |= PK_GC_UNTRACKED;
             SP() = begin;
             PUSH(&tmp);
             DISPATCH();
         }
-        case OP_BUILD_LIST: {
+        CASE(OP_BUILD_LIST) {
             py_TValue tmp;
             py_newlistn(&tmp, byte.arg);
             py_TValue* begin = SP() - byte.arg;
@@ -594,7 +1151,7 @@ __NEXT_STEP:
             PUSH(&tmp);
             DISPATCH();
         }
-        case OP_BUILD_DICT: {
+        CASE(OP_BUILD_DICT) {
             py_TValue* begin = SP() - byte.arg * 2;
             py_Ref tmp = py_pushtmp();
             py_newdict(tmp);
@@ -606,7 +1163,7 @@ __NEXT_STEP:
             PUSH(tmp);
             DISPATCH();
         }
-        case OP_BUILD_SET: {
+        CASE(OP_BUILD_SET) {
             py_TValue* begin = SP() - byte.arg;
             py_Ref typeobject_set = py_getdict(self->builtins, py_name("set"));
             assert(typeobject_set != NULL);
@@ -628,7 +1185,7 @@ __NEXT_STEP:
             PUSH(&tmp);
             DISPATCH();
         }
-        case OP_BUILD_SLICE: {
+        CASE(OP_BUILD_SLICE) {
             // [start, stop, step]
             py_TValue tmp;
             py_ObjectRef slots = py_newslice(&tmp);
@@ -639,7 +1196,7 @@ __NEXT_STEP:
             PUSH(&tmp);
             DISPATCH();
         }
-        case OP_BUILD_STRING: {
+        CASE(OP_BUILD_STRING) {
             py_TValue* begin = SP() - byte.arg;
             c11_sbuf ss;
             c11_sbuf__ctor(&ss);
@@ -653,7 +1210,11 @@ __NEXT_STEP:
         }
         /*****************************/
 #define CASE_BINARY_OP(label, op, rop)                                                             \
-    case label: {                                                                                  \
+    CASE(label) {                                                                                  \
+        if(number_binaryop(label, SECOND(), TOP())) {                                              \
+            POP();                                                                                 \
+            DISPATCH();                                                                            \
+        }                                                                                          \
         if(!pk_stack_binaryop(self, op, rop)) goto __ERROR;                                        \
         POP();                                                                                     \
         *TOP() = self->last_retval;                                                                \
@@ -679,14 +1240,14 @@ __NEXT_STEP:
             CASE_BINARY_OP(OP_COMPARE_GT, __gt__, __lt__)
             CASE_BINARY_OP(OP_COMPARE_GE, __ge__, __le__)
 #undef CASE_BINARY_OP
-        case OP_IS_OP: {
+        CASE(OP_IS_OP) {
             bool res = py_isidentical(SECOND(), TOP());
             POP();
             if(byte.arg) res = !res;
             py_newbool(TOP(), res);
             DISPATCH();
         }
-        case OP_CONTAINS_OP: {
+        CASE(OP_CONTAINS_OP) {
             // [b, a] -> b __contains__ a (a in b) -> [retval]
             py_Ref magic = py_tpfindmagic(SECOND()->type, __contains__);
             if(magic) {
@@ -707,29 +1268,53 @@ __NEXT_STEP:
             goto __ERROR;
         }
             /*****************************************/
-        case OP_JUMP_FORWARD: DISPATCH_JUMP((int16_t)byte.arg);
-        case OP_POP_JUMP_IF_NOT_MATCH: {
+        CASE(OP_JUMP_FORWARD) {
+#if PK_ENABLE_WATCHDOG
+            // loop back-edges are emitted as backward `JUMP_FORWARD`
+            if((int16_t)byte.arg < 0) WATCHDOG_POLL();
+#endif
+            DISPATCH_JUMP((int16_t)byte.arg);
+        }
+        CASE(OP_POP_JUMP_IF_NOT_MATCH) {
             int res = py_equal(SECOND(), TOP());
             if(res < 0) goto __ERROR;
             STACK_SHRINK(2);
             if(!res) DISPATCH_JUMP((int16_t)byte.arg);
             DISPATCH();
         }
-        case OP_POP_JUMP_IF_FALSE: {
+        CASE(OP_POP_JUMP_IF_FALSE) {
             int res = py_bool(TOP());
             if(res < 0) goto __ERROR;
             POP();
             if(!res) DISPATCH_JUMP((int16_t)byte.arg);
             DISPATCH();
         }
-        case OP_POP_JUMP_IF_TRUE: {
+        CASE(OP_COMPARE_JUMP_IF_FALSE) {
+            // [a, b] -> a <cmp> b, `byte.arg` is the comparison opcode
+            Opcode cmp = (Opcode)byte.arg;
+            if(number_binaryop(cmp, SECOND(), TOP())) {
+                POP();
+            } else {
+                if(!stack_compareop(self, cmp)) goto __ERROR;
+                POP();
+                *TOP() = self->last_retval;
+            }
+            // POP_JUMP_IF_FALSE
+            byte = co_codes[++frame->ip];
+            int res = py_bool(TOP());
+            if(res < 0) goto __ERROR;
+            POP();
+            if(!res) DISPATCH_JUMP((int16_t)byte.arg);
+            DISPATCH();
+        }
+        CASE(OP_POP_JUMP_IF_TRUE) {
             int res = py_bool(TOP());
             if(res < 0) goto __ERROR;
             POP();
             if(res) DISPATCH_JUMP((int16_t)byte.arg);
             DISPATCH();
         }
-        case OP_JUMP_IF_TRUE_OR_POP: {
+        CASE(OP_JUMP_IF_TRUE_OR_POP) {
             int res = py_bool(TOP());
             if(res < 0) goto __ERROR;
             if(res) {
@@ -739,7 +1324,7 @@ __NEXT_STEP:
                 DISPATCH();
             }
         }
-        case OP_JUMP_IF_FALSE_OR_POP: {
+        CASE(OP_JUMP_IF_FALSE_OR_POP) {
             int res = py_bool(TOP());
             if(res < 0) goto __ERROR;
             if(!res) {
@@ -749,7 +1334,7 @@ __NEXT_STEP:
                 DISPATCH();
             }
         }
-        case OP_SHORTCUT_IF_FALSE_OR_POP: {
+        CASE(OP_SHORTCUT_IF_FALSE_OR_POP) {
             int res = py_bool(TOP());
             if(res < 0) goto __ERROR;
             if(!res) {                      // [b, False]
@@ -761,19 +1346,80 @@ __NEXT_STEP:
                 DISPATCH();
             }
         }
-        case OP_LOOP_CONTINUE: {
+        CASE(OP_LOOP_CONTINUE) {
+            WATCHDOG_POLL();
             DISPATCH_JUMP((int16_t)byte.arg);
         }
-        case OP_LOOP_BREAK: {
+        CASE(OP_LOOP_BREAK) {
             DISPATCH_JUMP((int16_t)byte.arg);
         }
         /*****************************************/
-        case OP_CALL: {
+        CASE(OP_CALL) {
+            if(++ADAPTIVE_COUNTER() >= ADAPTIVE_WARMUP) {
+                ADAPTIVE_COUNTER() = 0;
+                int kwargc = byte.arg >> 8;
+                py_StackRef p1 = SP() - kwargc * 2;
+                py_StackRef p0 = p1 - (byte.arg & 0xFF) - 2;
+                if(kwargc == 0 && is_py_exact_args_call(p0, p1)) {
+                    QUICKEN(OP_CALL_PY_EXACT_ARGS);
+                } else if(callplan_fill(self, co_caches + frame->ip, p0, p1, kwargc)) {
+                    QUICKEN(OP_CALL_PY_PLANNED);
+                }
+            }
             if(self->heap.gc_enabled) ManagedHeap__collect_hint(&self->heap);
             vectorcall_opcall(byte.arg & 0xFF, byte.arg >> 8);
             DISPATCH();
         }
-        case OP_CALL_VARGS: {
+        CASE(OP_CALL_PY_EXACT_ARGS) {
+            // same as `FuncType_SIMPLE` in `VM__vectorcall`
+            py_StackRef p0 = SP() - byte.arg - 2;
+            if(!is_py_exact_args_call(p0, SP())) DEOPT(OP_CALL);
+            if(self->heap.gc_enabled) ManagedHeap__collect_hint(&self->heap);
+            Function* fn = PyObject__userdata_raw(p0->_obj);
+            const CodeObject* co = &fn->decl->code;
+            py_StackRef argv = p0 + 1 + (int)py_isnil(p0 + 1);
+            py_StackRef p1 = SP();
+            self->curr_function = p0;
+            SP() = argv + co->nlocals;
+            // initialize local variables to py_NIL
+            memset(p1, 0, (char*)SP() - (char*)p1);
+            VM__push_frame(self, Frame__new(co, p0, fn->module, &fn->globals, argv, false));
+            frame = self->top_frame;
+            goto __NEXT_FRAME;
+        }
+        CASE(OP_CALL_PY_PLANNED) {
+            // [callable, <self>, args..., kwargs...] bound in place by a `CallPlan`
+            int kwargc = byte.arg >> 8;
+            py_StackRef p1 = SP() - kwargc * 2;
+            py_StackRef p0 = p1 - (byte.arg & 0xFF) - 2;
+            const CallPlan* plan = co_caches[frame->ip].plan;
+            if(p0->type != tp_function) DEOPT(OP_CALL);
+            Function* fn = PyObject__userdata_raw(p0->_obj);
+            const FuncDecl* decl = fn->decl;
+            py_StackRef argv = p0 + 1 + (int)py_isnil(p0 + 1);
+            if(decl->uid != plan->decl_uid || p1 - argv != plan->argc) DEOPT(OP_CALL);
+            if(self->heap.gc_enabled) ManagedHeap__collect_hint(&self->heap);
+            const CodeObject* co = &decl->code;
+            // keyword values may overlap their target slots
+            py_TValue* buf = self->vectorcall_buffer;
+            for(int j = 0; j < kwargc; j++) {
+                buf[j] = p1[2 * j + 1];
+            }
+            const FuncDeclKwArg* kwdefaults = decl->kwargs.data;
+            for(int i = plan->argc; i < plan->nparams; i++) {
+                argv[i] = kwdefaults[i - decl->args.length].value;
+            }
+            self->curr_function = p0;
+            SP() = argv + co->nlocals;
+            memset(argv + plan->nparams, 0, (char*)SP() - (char*)(argv + plan->nparams));
+            for(int j = 0; j < kwargc; j++) {
+                argv[plan->kw_index[j]] = buf[j];
+            }
+            VM__push_frame(self, Frame__new(co, p0, fn->module, &fn->globals, argv, false));
+            frame = self->top_frame;
+            goto __NEXT_FRAME;
+        }
+        CASE(OP_CALL_VARGS) {
             // [_0, _1, _2 | k1, v1, k2, v2]
             uint16_t argc = byte.arg & 0xFF;
             uint16_t kwargc = byte.arg >> 8;
@@ -828,12 +1474,13 @@ __NEXT_STEP:
             vectorcall_opcall(argc, kwargc);
             DISPATCH();
         }
-        case OP_RETURN_VALUE: {
+        CASE(OP_RETURN_VALUE) {
             if(byte.arg == BC_NOARG) {
                 self->last_retval = POPX();
             } else {
                 py_newnone(&self->last_retval);
             }
+            if(frame->is_ctor) self->last_retval = frame->p0[-1];
             VM__pop_frame(self);
             if(frame == base_frame) {  // [ frameBase<- ]
                 return RES_RETURN;
@@ -844,7 +1491,7 @@ __NEXT_STEP:
             }
             DISPATCH();
         }
-        case OP_YIELD_VALUE: {
+        CASE(OP_YIELD_VALUE) {
             if(byte.arg == 1) {
                 py_newnone(py_retval());
             } else {
@@ -853,35 +1500,37 @@ __NEXT_STEP:
             }
             return RES_YIELD;
         }
-        case OP_FOR_ITER_YIELD_VALUE: {
+        CASE(OP_FOR_ITER_YIELD_VALUE) {
             int res = py_next(TOP());
             if(res == -1) goto __ERROR;
             if(res) {
                 return RES_YIELD;
             } else {
                 assert(self->last_retval.type == tp_StopIteration);
-                BaseException* ud = py_touserdata(py_retval());
-                py_ObjectRef value = &ud->args;
-                if(py_isnil(value)) value = py_None();
+                py_ObjectRef value = py_None();
+                if(py_retval()->is_ptr) {
+                    BaseException* ud = py_touserdata(py_retval());
+                    if(!py_isnil(&ud->args)) value = &ud->args;
+                }
                 *TOP() = *value;  // [iter] -> [retval]
                 DISPATCH_JUMP((int16_t)byte.arg);
             }
         }
         /////////
-        case OP_LIST_APPEND: {
+        CASE(OP_LIST_APPEND) {
             // [list, iter, value]
             py_list_append(THIRD(), TOP());
             POP();
             DISPATCH();
         }
-        case OP_DICT_ADD: {
+        CASE(OP_DICT_ADD) {
             // [dict, iter, key, value]
             bool ok = py_dict_setitem(FOURTH(), SECOND(), TOP());
             if(!ok) goto __ERROR;
             STACK_SHRINK(2);
             DISPATCH();
         }
-        case OP_SET_ADD: {
+        CASE(OP_SET_ADD) {
             // [set, iter, value]
             py_push(THIRD());  // [| set]
             if(!py_pushmethod(py_name("add"))) {
@@ -893,36 +1542,52 @@ __NEXT_STEP:
             DISPATCH();
         }
         /////////
-        case OP_UNARY_NEGATIVE: {
+        CASE(OP_UNARY_NEGATIVE) {
+            if(TOP()->type == tp_int) {
+                TOP()->_i64 = -TOP()->_i64;
+                DISPATCH();
+            }
+            if(TOP()->type == tp_float) {
+                TOP()->_f64 = -TOP()->_f64;
+                DISPATCH();
+            }
             if(!pk_callmagic(__neg__, 1, TOP())) goto __ERROR;
             *TOP() = self->last_retval;
             DISPATCH();
         }
-        case OP_UNARY_NOT: {
+        CASE(OP_UNARY_NOT) {
             int res = py_bool(TOP());
             if(res < 0) goto __ERROR;
             py_newbool(TOP(), !res);
             DISPATCH();
         }
-        case OP_UNARY_STAR: {
+        CASE(OP_UNARY_STAR) {
             py_TValue value = POPX();
             int* level = py_newobject(SP()++, tp_star_wrapper, 1, sizeof(int));
             *level = byte.arg;
             py_setslot(TOP(), 0, &value);
             DISPATCH();
         }
-        case OP_UNARY_INVERT: {
+        CASE(OP_UNARY_INVERT) {
+            if(TOP()->type == tp_int) {
+                TOP()->_i64 = ~TOP()->_i64;
+                DISPATCH();
+            }
             if(!pk_callmagic(__invert__, 1, TOP())) goto __ERROR;
             *TOP() = self->last_retval;
             DISPATCH();
         }
         ////////////////
-        case OP_GET_ITER: {
+        CASE(OP_GET_ITER) {
             if(!py_iter(TOP())) goto __ERROR;
             *TOP() = *py_retval();
             DISPATCH();
         }
-        case OP_FOR_ITER: {
+        CASE(OP_FOR_ITER) {
+            if(++ADAPTIVE_COUNTER() >= ADAPTIVE_WARMUP) {
+                ADAPTIVE_COUNTER() = 0;
+                QUICKEN(specialize_for_iter(TOP()));
+            }
             int res = py_next(TOP());
             if(res == -1) goto __ERROR;
             if(res) {
@@ -934,8 +1599,95 @@ __NEXT_STEP:
                 DISPATCH_JUMP((int16_t)byte.arg);
             }
         }
+        CASE(OP_GET_RANGE_ITER) {
+            // [range, args...]
+            py_TValue* argv = SP() - byte.arg;
+            py_Ref callable = argv - 1;
+            bool is_range = callable->type == tp_type && py_totype(callable) == tp_range;
+            if(!is_range || !pk_newrangecounter(callable, byte.arg, argv)) {
+                // not the builtin `range`, or arguments it does not count with
+                if(!py_call(callable, byte.arg, argv)) goto __ERROR;
+                *callable = *py_retval();
+                if(!py_iter(callable)) goto __ERROR;
+                *callable = *py_retval();
+            }
+            SP() = argv;  // [iter]
+            DISPATCH();
+        }
+        CASE(OP_FOR_RANGE_STORE_FAST) {
+            assert(!frame->is_locals_special);
+            if(TOP()->type == tp_range_iterator && !TOP()->is_ptr) {
+                py_i64 value;
+                if(range_counter_next(TOP(), &value)) {
+                    int index = co_codes[++frame->ip].arg;
+                    number_setint(&frame->locals[index], value);
+                    DISPATCH();
+                }
+                POP();  // [iter] -> []
+                DISPATCH_JUMP((int16_t)byte.arg);
+            }
+            // a boxed iterator, the value is stored by the `STORE_FAST` in place
+            goto __FOR_RANGE_BOXED;
+        }
+        CASE(OP_FOR_RANGE) {
+            int res;
+            if(TOP()->type == tp_range_iterator && !TOP()->is_ptr) {
+                py_i64 value;
+                if(range_counter_next(TOP(), &value)) {
+                    number_setint(SP()++, value);
+                    DISPATCH();
+                }
+                POP();  // [iter] -> []
+                DISPATCH_JUMP((int16_t)byte.arg);
+            }
+        __FOR_RANGE_BOXED:
+            // `range` was rebound, see `OP_GET_RANGE_ITER`
+            res = py_next(TOP());
+            if(res == -1) goto __ERROR;
+            if(res) {
+                PUSH(py_retval());
+                DISPATCH();
+            }
+            POP();  // [iter] -> []
+            DISPATCH_JUMP((int16_t)byte.arg);
+        }
+        CASE(OP_FOR_ITER_LIST) {
+            if(TOP()->type != tp_list_iterator) DEOPT(OP_FOR_ITER);
+            list_iterator* ud = PyObject__userdata_raw(TOP()->_obj);
+            if(ud->index < ud->vec->length) {
+                PUSH(c11__at(py_TValue, ud->vec, ud->index));
+                ud->index++;
+                DISPATCH();
+            }
+            POP();  // [iter] -> []
+            DISPATCH_JUMP((int16_t)byte.arg);
+        }
+        CASE(OP_FOR_ITER_TUPLE) {
+            if(TOP()->type != tp_tuple_iterator) DEOPT(OP_FOR_ITER);
+            tuple_iterator* ud = PyObject__userdata_raw(TOP()->_obj);
+            if(ud->index < ud->length) {
+                PUSH(ud->p + ud->index);
+                ud->index++;
+                DISPATCH();
+            }
+            POP();  // [iter] -> []
+            DISPATCH_JUMP((int16_t)byte.arg);
+        }
+        CASE(OP_FOR_ITER_RANGE) {
+            if(TOP()->type != tp_range_iterator) DEOPT(OP_FOR_ITER);
+            RangeIterator* ud = PyObject__userdata_raw(TOP()->_obj);
+            bool has_next = ud->range.step > 0 ? ud->current < ud->range.stop
+                                               : ud->current > ud->range.stop;
+            if(has_next) {
+                number_setint(SP()++, ud->current);
+                ud->current += ud->range.step;
+                DISPATCH();
+            }
+            POP();  // [iter] -> []
+            DISPATCH_JUMP((int16_t)byte.arg);
+        }
         ////////
-        case OP_IMPORT_PATH: {
+        CASE(OP_IMPORT_PATH) {
             py_Ref path_object = c11__at(py_TValue, &frame->co->consts, byte.arg);
             const char* path = py_tostr(path_object);
             int res = py_import(path);
@@ -947,7 +1699,7 @@ __NEXT_STEP:
             PUSH(py_retval());
             DISPATCH();
         }
-        case OP_POP_IMPORT_STAR: {
+        CASE(OP_POP_IMPORT_STAR) {
             // [module]
             NameDict* dict = PyObject__dict(TOP()->_obj);
             py_ItemRef all = NameDict__try_get(dict, __all__);
@@ -981,19 +1733,20 @@ __NEXT_STEP:
             DISPATCH();
         }
         ////////
-        case OP_UNPACK_SEQUENCE: {
-            py_TValue* p;
+        CASE(OP_UNPACK_SEQUENCE) {
+            py_TValue* p = NULL;
             int length;
 
             switch(TOP()->type) {
                 case tp_tuple: {
                     length = py_tuple_len(TOP());
-                    p = py_tuple_data(TOP());
+                    p = PyObject__slots_raw(TOP()->_obj);
                     break;
                 }
                 case tp_list: {
-                    length = py_list_len(TOP());
-                    p = py_list_data(TOP());
+                    List* list = PyObject__userdata_raw(TOP()->_obj);
+                    length = list->length;
+                    p = list->data;
                     break;
                 }
                 case tp_vec2i: {
@@ -1049,7 +1802,7 @@ __NEXT_STEP:
             }
             DISPATCH();
         }
-        case OP_UNPACK_EX: {
+        CASE(OP_UNPACK_EX) {
             py_TValue* p;
             int length = pk_arrayview(TOP(), &p);
             if(length == -1) {
@@ -1072,7 +1825,7 @@ __NEXT_STEP:
             DISPATCH();
         }
         ///////////
-        case OP_BEGIN_CLASS: {
+        CASE(OP_BEGIN_CLASS) {
             // [base]
             py_Name name = co_names[byte.arg];
             py_Type base;
@@ -1101,9 +1854,13 @@ __NEXT_STEP:
             self->curr_class = TOP();
             DISPATCH();
         }
-        case OP_END_CLASS: {
+        CASE(OP_END_CLASS) {
             // [cls or decorated]
             py_Name name = co_names[byte.arg];
+            // decorators run before this, so they can still set `__slots__`
+            if(py_istype(TOP(), tp_type)) {
+                if(!py_TypeInfo__apply_slots(py_touserdata(TOP()))) goto __ERROR;
+            }
             if(!Frame__setglobal(frame, name, TOP())) goto __ERROR;
 
             if(py_istype(TOP(), tp_type)) {
@@ -1126,7 +1883,7 @@ __NEXT_STEP:
             self->curr_class = NULL;
             DISPATCH();
         }
-        case OP_STORE_CLASS_ATTR: {
+        CASE(OP_STORE_CLASS_ATTR) {
             assert(self->curr_class);
             py_Name name = co_names[byte.arg];
             // TOP() can be a function, classmethod or custom decorator
@@ -1134,7 +1891,7 @@ __NEXT_STEP:
             POP();
             DISPATCH();
         }
-        case OP_ADD_CLASS_ANNOTATION: {
+        CASE(OP_ADD_CLASS_ANNOTATION) {
             assert(self->curr_class);
             // [type_hint string]
             py_TypeInfo* ti = py_touserdata(self->curr_class);
@@ -1146,7 +1903,7 @@ __NEXT_STEP:
             DISPATCH();
         }
         ///////////
-        case OP_WITH_ENTER: {
+        CASE(OP_WITH_ENTER) {
             // [expr]
             py_push(TOP());
             if(!py_pushmethod(__enter__)) {
@@ -1156,7 +1913,7 @@ __NEXT_STEP:
             vectorcall_opcall(0, 0);
             DISPATCH();
         }
-        case OP_WITH_EXIT: {
+        CASE(OP_WITH_EXIT) {
             // [expr]
             py_push(TOP());
             if(!py_pushmethod(__exit__)) {
@@ -1168,15 +1925,7 @@ __NEXT_STEP:
             DISPATCH();
         }
         ///////////
-        case OP_BEGIN_TRY: {
-            Frame__begin_try(frame, SP());
-            DISPATCH();
-        }
-        case OP_END_TRY: {
-            c11_vector__pop(&frame->exc_stack);
-            DISPATCH();
-        }
-        case OP_EXCEPTION_MATCH: {
+        CASE(OP_EXCEPTION_MATCH) {
             bool ok = false;
             bool has_invalid = false;
             if(TOP()->type == tp_type) {
@@ -1204,22 +1953,24 @@ __NEXT_STEP:
             if(has_invalid) {
                 py_newnil(&self->unhandled_exc);
                 TypeError("catching classes that do not inherit from BaseException is not allowed");
-                c11_vector__pop(&frame->exc_stack);
                 goto __ERROR;
             } else {
                 py_newbool(TOP(), ok);
                 DISPATCH();
             }
         }
-        case OP_HANDLE_EXCEPTION: {
-            FrameExcInfo* info = Frame__top_exc_info(frame);
-            assert(info != NULL && py_isnil(&info->exc));
-            info->exc = self->unhandled_exc;
+        CASE(OP_HANDLE_EXCEPTION) {
+            py_BaseException__materialize(&self->unhandled_exc);
+            PUSH(&self->unhandled_exc);
             py_newnil(&self->unhandled_exc);
             DISPATCH();
         }
-        case OP_RAISE: {
+        CASE(OP_RAISE) {
             // [exception]
+            if(TOP()->type == tp_type && py_totype(TOP()) == tp_StopIteration) {
+                StopIteration();
+                goto __ERROR;
+            }
             if(py_istype(TOP(), tp_type)) {
                 if(!py_tpcall(py_totype(TOP()), 0, NULL)) goto __ERROR;
                 py_assign(TOP(), py_retval());
@@ -1231,7 +1982,7 @@ __NEXT_STEP:
             py_raise(TOP());
             goto __ERROR;
         }
-        case OP_RAISE_ASSERT: {
+        CASE(OP_RAISE_ASSERT) {
             if(byte.arg) {
                 if(!py_str(TOP())) goto __ERROR;
                 POP();
@@ -1241,23 +1992,13 @@ __NEXT_STEP:
             }
             goto __ERROR;
         }
-        case OP_RE_RAISE: {
-            if(py_isnil(&self->unhandled_exc)) {
-                FrameExcInfo* info = Frame__top_exc_info(frame);
-                assert(info != NULL && !py_isnil(&info->exc));
-                self->unhandled_exc = info->exc;
-            }
-            c11_vector__pop(&frame->exc_stack);
+        CASE(OP_RE_RAISE) {
+            // a bare `raise` re-raises [exc] of its except clause
+            if(py_isnil(&self->unhandled_exc)) self->unhandled_exc = *TOP();
             goto __ERROR_RE_RAISE;
         }
-        case OP_PUSH_EXCEPTION: {
-            FrameExcInfo* info = Frame__top_exc_info(frame);
-            assert(info != NULL && !py_isnil(&info->exc));
-            PUSH(&info->exc);
-            DISPATCH();
-        }
         //////////////////
-        case OP_FORMAT_STRING: {
+        CASE(OP_FORMAT_STRING) {
             py_Ref spec = c11__at(py_TValue, &frame->co->consts, byte.arg);
             bool ok = pk_format_object(self, TOP(), py_tosv(spec));
             if(!ok) goto __ERROR;
@@ -1269,27 +2010,34 @@ __NEXT_STEP:
 
     c11__unreachable();
 
+__UNBOUND_FAST:
+    // `byte` is the LOAD_FAST part of a superinstruction
+    UnboundLocalError(c11__getitem(py_Name, &frame->co->varnames, byte.arg));
+    goto __ERROR;
+
 __ERROR:
     assert(!py_isnil(&self->unhandled_exc));
-    py_BaseException__stpush(frame,
-                             &self->unhandled_exc,
-                             frame->co->src,
-                             Frame__lineno(frame),
-                             !frame->is_locals_special ? frame->co->name->data : NULL);
+    if(!self->unhandled_exc.is_ptr) {
+        // an exhausted iterator returning to `py_next()` needs no traceback
+        bool to_next = frame == base_frame && self->recursion_depth == self->next_depth + 1;
+        if(to_next && !Frame__find_handler(frame)) goto __ERROR_RE_RAISE;
+        py_BaseException__materialize(&self->unhandled_exc);
+    }
+    py_BaseException__stpush(frame, &self->unhandled_exc, NULL, 0);
 __ERROR_RE_RAISE:
-    do {
-        self->curr_class = NULL;
-        self->curr_function = NULL;
-    } while(0);
+    self->curr_function = NULL;
 
     int target = Frame__goto_exception_handler(frame, &self->stack, &self->unhandled_exc);
     if(target >= 0) {
         // 1. Exception can be handled inside the current frame
+        // a class body is still running if its class was not unwound
+        if(self->curr_class && self->curr_class >= SP()) self->curr_class = NULL;
         DISPATCH_JUMP_ABSOLUTE(target);
     } else {
         // 2. Exception need to be propagated to the upper frame
         bool is_base_frame_to_be_popped = frame == base_frame;
         VM__pop_frame(self);
+        if(self->curr_class && self->curr_class >= SP()) self->curr_class = NULL;
         if(self->top_frame == NULL || is_base_frame_to_be_popped) {
             // propagate to the top level
             return RES_ERROR;
@@ -1514,6 +2262,8 @@ bool pk_format_object(VM* self, py_Ref val, c11_sv spec) {
     return true;
 }
 
+#undef CASE
+#undef DISPATCH_NEXT
 #undef DISPATCH
 #undef DISPATCH_JUMP
 #undef DISPATCH_JUMP_ABSOLUTE
@@ -1530,3 +2280,8 @@ bool pk_format_object(VM* self, py_Ref val, c11_sv spec) {
 #undef INSERT_THIRD
 #undef vectorcall_opcall
 #undef RESET_CO_CACHE
+#undef MODULE_VERSION
+#undef ADAPTIVE_WARMUP
+#undef ADAPTIVE_COUNTER
+#undef QUICKEN
+#undef DEOPT
@@ -22,15 +22,6 @@ void FastLocals__to_dict(py_TValue* locals, const CodeObject* co) {
     py_pop();
 }
 
-NameDict* FastLocals__to_namedict(py_TValue* locals, const CodeObject* co) {
-    NameDict* dict = NameDict__new(PK_INST_ATTR_LOAD_FACTOR);
-    c11__foreach(c11_smallmap_n2d_KV, &co->varnames_inv, entry) {
-        py_Ref val = &locals[entry->value];
-        if(!py_isnil(val)) NameDict__set(dict, entry->key, val);
-    }
-    return dict;
-}
-
 py_Frame* Frame__new(const CodeObject* co,
                      py_StackRef p0,
                      py_GlobalRef module,
@@ -50,48 +41,47 @@ py_Frame* Frame__new(const CodeObject* co,
     self->globals = globals;
     self->locals = locals;
     self->is_locals_special = is_locals_special;
+    self->is_ctor = false;
     self->ip = -1;
-    c11_vector__ctor(&self->exc_stack, sizeof(FrameExcInfo));
     return self;
 }
 
-void Frame__delete(py_Frame* self) {
-    c11_vector__dtor(&self->exc_stack);
-    FixedMemoryPool__dealloc(&pk_current_vm->pool_frame, self);
+void Frame__delete(py_Frame* self) { FixedMemoryPool__dealloc(&pk_current_vm->pool_frame, self); }
+
+py_StackRef Frame__stack_base(py_Frame* self) {
+    if(self->is_locals_special) return self->p0;
+    return self->locals + self->co->nlocals;
 }
 
-int Frame__goto_exception_handler(py_Frame* self, ValueStack* value_stack, py_Ref exc) {
-    FrameExcInfo* p = self->exc_stack.data;
-    for(int i = self->exc_stack.length - 1; i >= 0; i--) {
-        if(py_isnil(&p[i].exc)) {
-            value_stack->sp = (self->p0 + p[i].offset);  // unwind the stack
-            return c11__at(CodeBlock, &self->co->blocks, p[i].iblock)->end;
-        } else {
-            self->exc_stack.length--;
-        }
+const CodeHandler* Frame__find_handler(py_Frame* self) {
+    // handlers of nested try blocks come after the outer ones
+    const CodeHandler* handlers = self->co->handlers.data;
+    for(int i = self->co->handlers.length - 1; i >= 0; i--) {
+        if(self->ip >= handlers[i].start && self->ip < handlers[i].end) return &handlers[i];
     }
-    return -1;
+    return NULL;
 }
 
-void Frame__begin_try(py_Frame* self, py_TValue* sp) {
-    int iblock = Frame__iblock(self);
-    assert(iblock >= 0);
-    FrameExcInfo* info = c11_vector__emplace(&self->exc_stack);
-    info->iblock = iblock;
-    info->offset = (int)(sp - self->p0);
-    py_newnil(&info->exc);
+int Frame__goto_exception_handler(py_Frame* self, ValueStack* value_stack, py_Ref exc) {
+    const CodeHandler* handler = Frame__find_handler(self);
+    if(handler == NULL) return -1;
+    value_stack->sp = Frame__stack_base(self) + handler->depth;  // unwind the stack
+    return handler->end;
 }
 
-FrameExcInfo* Frame__top_exc_info(py_Frame* self) {
-    if(self->exc_stack.length == 0) return NULL;
-    return &c11_vector__back(FrameExcInfo, &self->exc_stack);
+py_Ref Frame__handled_exc(py_Frame* self) {
+    const CodeBlock* blocks = self->co->blocks.data;
+    for(int i = Frame__iblock(self); i > 0; i = blocks[i].parent) {
+        // the except clause keeps its exception at the bottom of its stack
+        if(blocks[i].type == CodeBlockType_EXCEPT) return Frame__stack_base(self) + blocks[i].depth;
+    }
+    return NULL;
 }
 
 void Frame__gc_mark(py_Frame* self, c11_vector* p_stack) {
     pk__mark_value(self->globals);
     if(self->is_locals_special) pk__mark_value(self->locals);
     CodeObject__gc_mark(self->co, p_stack);
-    c11__foreach(FrameExcInfo, &self->exc_stack, info) { pk__mark_value(&info->exc); }
 }
 
 int Frame__lineno(const py_Frame* self) {
@@ -148,14 +138,6 @@ py_StackRef Frame__getlocal_noproxy(py_Frame* self, py_Name name) {
     return &self->locals[index];
 }
 
-py_Ref Frame__getclosure(py_Frame* self, py_Name name) {
-    if(self->is_locals_special) return NULL;
-    assert(self->p0->type == tp_function);
-    Function* ud = py_touserdata(self->p0);
-    if(ud->closure == NULL) return NULL;
-    return NameDict__try_get(ud->closure, name);
-}
-
 SourceLocation Frame__source_location(py_Frame* self) {
     SourceLocation loc;
     loc.lineno = Frame__lineno(self);
@@ -5,20 +5,31 @@
 #include "pocketpy/pocketpy.h"
 #include <stdbool.h>
 #include <assert.h>
+#include <string.h>
+
+static void Generator__backup(Generator* ud, py_TValue* begin, py_TValue* end) {
+    int length = end - begin;
+    if(length > ud->backup_capacity) {
+        ud->backup_capacity = c11__max(length, ud->backup_capacity * 2);
+        ud->backup = PK_REALLOC(ud->backup, sizeof(py_TValue) * ud->backup_capacity);
+    }
+    memcpy(ud->backup, begin, sizeof(py_TValue) * length);
+    ud->backup_length = length;
+}
 
 void pk_newgenerator(py_Ref out, py_Frame* frame, py_TValue* begin, py_TValue* end) {
-    Generator* ud = py_newobject(out, tp_generator, 1, sizeof(Generator));
+    Generator* ud = py_newobject(out, tp_generator, 0, sizeof(Generator));
     ud->frame = frame;
     ud->state = 0;
-    py_Ref tmp = py_getslot(out, 0);
-    py_newlist(tmp);
-    for(py_TValue* p = begin; p != end; p++) {
-        py_list_append(tmp, p);
-    }
+    ud->backup = NULL;
+    ud->backup_length = 0;
+    ud->backup_capacity = 0;
+    Generator__backup(ud, begin, end);
 }
 
 void Generator__dtor(Generator* ud) {
     if(ud->frame) Frame__delete(ud->frame);
+    PK_FREE(ud->backup);
 }
 
 bool generator__next__(int argc, py_Ref argv) {
@@ -31,22 +42,21 @@ bool generator__next__(int argc, py_Ref argv) {
     // reset frame->p0
     assert(!ud->frame->is_locals_special);
     int locals_offset = ud->frame->locals - ud->frame->p0;
-    ud->frame->p0 = py_peek(0);
-    ud->frame->locals = ud->frame->p0 + locals_offset;
-    
+    ud->frame->p0 = p0;
+    ud->frame->locals = p0 + locals_offset;
+
     // restore the context
-    py_Ref backup = py_getslot(argv, 0);
-    int length = py_list_len(backup);
-    py_TValue* p = py_list_data(backup);
-    for(int i = 0; i < length; i++)
-        py_push(&p[i]);
-    py_list_clear(backup);
+    memcpy(p0, ud->backup, sizeof(py_TValue) * ud->backup_length);
+    vm->stack.sp = p0 + ud->backup_length;
+    ud->backup_length = 0;
 
     // push frame
     VM__push_frame(vm, ud->frame);
     ud->frame = NULL;
 
     FrameResult res = VM__run_top_frame(vm);
+    // the generator may have become old during the run
+    ud = py_touserdata(argv);
 
     if(res == RES_ERROR) {
         ud->state = 2;  // end this generator immediately on error
@@ -60,9 +70,7 @@ bool generator__next__(int argc, py_Ref argv) {
     if(res == RES_YIELD) {
         // backup the context
         ud->frame = vm->top_frame;
-        for(py_StackRef p = ud->frame->p0; p != vm->stack.sp; p++) {
-            py_list_append(backup, p);
-        }
+        Generator__backup(ud, ud->frame->p0, vm->stack.sp);
         vm->stack.sp = ud->frame->p0;
         vm->top_frame = vm->top_frame->f_back;
         vm->recursion_depth--;
@@ -71,6 +79,7 @@ bool generator__next__(int argc, py_Ref argv) {
     } else {
         assert(res == RES_RETURN);
         ud->state = 2;
+        if(py_isnone(py_retval())) return StopIteration();
         // raise StopIteration(<retval>)
         bool ok = py_tpcall(tp_StopIteration, 1, py_retval());
         if(!ok) return false;
@@ -84,3 +93,171 @@ py_Type pk_generator__register() {
     py_bindmagic(type, __next__, generator__next__);
     return type;
 }
+
+/* task */
+bool py_newtask(py_OutRef out,
+                const char* source,
+                const char* filename,
+                enum py_CompileMode mode,
+                py_Ref module) {
+    if(module == NULL) module = pk_current_vm->main;
+    if(mode != EXEC_MODE && mode != EVAL_MODE) return ValueError("invalid compile mode");
+    if(!py_compile(source, filename, mode, false)) return false;
+    Task* ud = py_newobject(out, tp_task, 3, sizeof(Task));
+    ud->frame = NULL;
+    ud->p0 = NULL;
+    ud->state = 0;
+    py_newlist(py_getslot(out, 0));
+    py_setslot(out, 1, py_retval());
+    py_setslot(out, 2, module);
+    return true;
+}
+
+void Task__dtor(Task* ud) {
+    py_Frame* frame = ud->frame;
+    while(frame) {
+        py_Frame* next = frame->f_back;
+        Frame__delete(frame);
+        frame = next;
+    }
+}
+
+int py_exec_budget(py_Ref task, py_i64 max_instructions) {
+    VM* vm = pk_current_vm;
+    Task* ud = py_touserdata(task);
+    if(ud->state == 2) {
+        RuntimeError("task is already finished");
+        return -1;
+    }
+    if(ud->state == 3) {
+        RuntimeError("task is already running");
+        return -1;
+    }
+
+    py_StackRef p0 = vm->stack.sp;
+    py_Frame* base_frame;
+    if(ud->state == 0) {
+        CodeObject* co = py_touserdata(py_getslot(task, 1));
+        py_Ref module = py_getslot(task, 2);
+        base_frame = Frame__new(co, p0, module, module, py_NIL(), true);
+        VM__push_frame(vm, base_frame);
+    } else {
+        base_frame = ud->frame;
+        // restore the context
+        py_Ref backup = py_getslot(task, 0);
+        int length = py_list_len(backup);
+        py_TValue* p = py_list_data(backup);
+        for(int i = 0; i < length; i++)
+            py_push(&p[i]);
+        py_list_clear(backup);
+        // push frames from the base, reset frame->p0
+        py_Frame* frame = ud->frame;
+        while(frame) {
+            py_Frame* next = frame->f_back;
+            frame->p0 = p0 + (frame->p0 - ud->p0);
+            if(!frame->is_locals_special) frame->locals = p0 + (frame->locals - ud->p0);
+            VM__push_frame(vm, frame);
+            frame = next;
+        }
+        ud->frame = NULL;
+    }
+
+    // tasks can be run from native functions of another task
+    BudgetInfo prev_budget = vm->budget_info;
+    vm->budget_info.remaining = max_instructions;
+    vm->budget_info.base_frame = base_frame;
+    VM__update_instrumentation(vm);
+
+    ud->state = 3;
+    FrameResult res = VM__run_frames(vm, base_frame);
+    // the task may have become old during the run
+    ud = py_touserdata(task);
+
+    prev_budget.remaining -= max_instructions - c11__max(vm->budget_info.remaining, 0);
+    vm->budget_info = prev_budget;
+    VM__update_instrumentation(vm);
+
+    if(res == RES_ERROR) {
+        ud->state = 2;
+        return -1;
+    }
+
+    if(res == RES_SUSPEND) {
+        // backup the context
+        py_Ref backup = py_getslot(task, 0);
+        for(py_StackRef p = p0; p != vm->stack.sp; p++) {
+            py_list_append(backup, p);
+        }
+        vm->stack.sp = p0;
+        // detach frames and link them from the base to the top
+        py_Frame* frame = vm->top_frame;
+        py_Frame* next = NULL;
+        while(true) {
+            py_Frame* back = frame->f_back;
+            frame->f_back = next;
+            next = frame;
+            vm->recursion_depth--;
+            if(frame == base_frame) {
+                vm->top_frame = back;
+                break;
+            }
+            frame = back;
+        }
+        ud->frame = base_frame;
+        ud->p0 = p0;
+        ud->state = 1;
+        return 0;
+    }
+
+    assert(res == RES_RETURN);
+    ud->state = 2;
+    return 1;
+}
+
+static bool task__new__(int argc, py_Ref argv) {
+    PY_CHECK_ARG_TYPE(1, tp_str);
+    enum py_CompileMode mode = EXEC_MODE;
+    if(argc == 3) {
+        PY_CHECK_ARG_TYPE(2, tp_str);
+        const char* s = py_tostr(py_arg(2));
+        if(strcmp(s, "exec") == 0) {
+            mode = EXEC_MODE;
+        } else if(strcmp(s, "eval") == 0) {
+            mode = EVAL_MODE;
+        } else {
+            return ValueError("mode must be 'exec' or 'eval'");
+        }
+    } else {
+        PY_CHECK_ARGC(2);
+    }
+    py_Ref module = py_inspect_currentmodule();
+    // `py_newtask` uses `py_retval()` as a temporary
+    if(!py_newtask(py_pushtmp(), py_tostr(py_arg(1)), "<task>", mode, module)) return false;
+    py_assign(py_retval(), py_peek(-1));
+    py_pop();
+    return true;
+}
+
+static bool task_run(int argc, py_Ref argv) {
+    PY_CHECK_ARGC(2);
+    PY_CHECK_ARG_TYPE(1, tp_int);
+    int res = py_exec_budget(argv, py_toint(py_arg(1)));
+    if(res == -1) return false;
+    py_newbool(py_retval(), res == 1);
+    return true;
+}
+
+static bool task_is_done(int argc, py_Ref argv) {
+    PY_CHECK_ARGC(1);
+    Task* ud = py_touserdata(argv);
+    py_newbool(py_retval(), ud->state == 2);
+    return true;
+}
+
+py_Type pk_task__register() {
+    py_Type type = pk_newtype("Task", tp_object, NULL, (py_Dtor)Task__dtor, false, true);
+    py_bindmagic(type, __new__, task__new__);
+    py_bindmethod(type, "run", task_run);
+    py_bindproperty(type, "is_done", task_is_done, NULL);
+    return type;
+}
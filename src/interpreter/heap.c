@@ -1,43 +1,48 @@
 #include "pocketpy/interpreter/heap.h"
 #include "pocketpy/config.h"
 #include "pocketpy/interpreter/objectpool.h"
+#include "pocketpy/interpreter/typeinfo.h"
 #include "pocketpy/objects/base.h"
 #include "pocketpy/common/sstream.h"
 #include "pocketpy/pocketpy.h"
+#include "pocketpy/interpreter/vm.h"
 #include <assert.h>
+#include <limits.h>
 
-static uint8_t encode_size_8b(int size, int* out_size) {
-    int bit_length = c11__bit_length(size);
-    int min_val = 1 << (bit_length - 1);
-    int gap = min_val;
-    float ratio = (float)(size - min_val) / gap;
-    int ratio_3bit = (int)(ratio * 7.999f);
-    *out_size = min_val + (int)(gap * ((float)ratio_3bit / 7.999f));
-    return (uint8_t)((bit_length << 3) | ratio_3bit);
-}
-
-static int decode_size_8b(uint8_t byte) {
-    int bit_length = byte >> 3;
-    int ratio_3bit = byte & 0x07;
-    int min_val = 1 << (bit_length - 1);
-    int gap = min_val;
-    float ratio = (float)ratio_3bit / 7.999f;
-    return min_val + (int)(gap * ratio);
-}
+#if PK_ENABLE_THREADS
+_Thread_local bool pk_gc_marking_parallel;
+#endif
 
 void ManagedHeap__ctor(ManagedHeap* self) {
     MultiPool__ctor(&self->small_objects);
     c11_vector__ctor(&self->large_objects, sizeof(PyObject*));
+    LargePool__ctor(&self->large_pool);
     c11_vector__ctor(&self->gc_roots, sizeof(PyObject*));
-    self->large_total_size = 0;
+    c11_vector__ctor(&self->remembered, sizeof(PyObject*));
+    c11_vector__ctor(&self->old_marked, sizeof(PyObject*));
+    c11_vector__ctor(&self->gray_again, sizeof(PyObject*));
+    self->large_young_begin = 0;
+    self->gc_phase = ManagedHeapPhase_IDLE;
+    self->gc_cycle_freed = 0;
+    self->gc_cycle_marked = 0;
+    self->large_sweep_index = 0;
+    self->large_sweep_end = 0;
+    self->large_sweep_live = 0;
 
     for(int i = 0; i < c11__count_array(self->freed_ma); i++) {
         self->freed_ma[i] = PK_GC_MIN_THRESHOLD;
     }
     self->gc_threshold = PK_GC_MIN_THRESHOLD;
     self->gc_counter = 0;
+    self->gc_young_count = 0;
+    self->gc_old_threshold = PK_GC_MIN_THRESHOLD;
+    self->gc_old_counter = 0;
+    self->run_depth = 0;
     self->gc_enabled = true;
     self->debug_callback = *py_None();
+#if PK_ENABLE_THREADS
+    self->gc_workers = NULL;
+#endif
 }
 
 void ManagedHeap__dtor(ManagedHeap* self) {
@@ -45,12 +50,22 @@ void ManagedHeap__dtor(ManagedHeap* self) {
     MultiPool__dtor(&self->small_objects);
     // large_objects
     for(int i = 0; i < self->large_objects.length; i++) {
+        // skip the entries already moved by an unfinished incremental sweep
+        bool moved = i >= self->large_sweep_live && i < self->large_sweep_index;
+        if(self->gc_phase == ManagedHeapPhase_SWEEP && moved) continue;
         PyObject* obj = c11__getitem(PyObject*, &self->large_objects, i);
         PyObject__dtor(obj);
-        PK_FREE(obj);
+        LargePool__dealloc(&self->large_pool, obj, obj->size_8b);
     }
     c11_vector__dtor(&self->large_objects);
+    LargePool__dtor(&self->large_pool);
     c11_vector__dtor(&self->gc_roots);
+    c11_vector__dtor(&self->remembered);
+    c11_vector__dtor(&self->old_marked);
+    c11_vector__dtor(&self->gray_again);
+#if PK_ENABLE_THREADS
+    ManagedHeap__set_threads(self, 1);
+#endif
 }
 
 static void ManagedHeap__fire_debug_callback_start(ManagedHeap* self) {
@@ -79,6 +94,7 @@ static void ManagedHeap__fire_debug_callback_stop(ManagedHeap* self,
     int64_t swpet_ms = (out_info->swpet_end_ns - out_info->mark_end_ns) / NANOS_PER_MS;
 
     c11_sbuf__write_cstr(&buf, DIVIDER);
+    pk_sprintf(&buf, "generation:   %s\n", out_info->is_minor ? "young" : "all");
     pk_sprintf(&buf, "start:        %f\n", out_info->start_ns / 1e9);
     pk_sprintf(&buf, "mark_ms:      %i\n", (py_i64)mark_ms);
     pk_sprintf(&buf, "swpet_ms:     %i\n", (py_i64)swpet_ms);
@@ -127,62 +143,151 @@ static void ManagedHeap__fire_debug_callback_stop(ManagedHeap* self,
     }
 }
 
-int ManagedHeap__collect_hint(ManagedHeap* self) {
-    if(self->gc_counter < self->gc_threshold) return 0;
-    self->gc_counter = 0;
+// promoting is only safe when no C function is on the stack, they may hold pointers
+// handed out by the accessors of `PyObject` before the object became old; the outermost
+// run counts 1, a native function called by the host or a nested run counts 1 more
+static bool ManagedHeap__can_promote(ManagedHeap* self) { return self->run_depth <= 1; }
 
-    ManagedHeapSwpetInfo* out_info = NULL;
-    if(!py_isnone(&self->debug_callback)) {
-        out_info = ManagedHeapSwpetInfo__new();
-        ManagedHeap__fire_debug_callback_start(self);
-    }
+// full collections of large heaps use the workers of `ManagedHeap__set_threads()`,
+// the debug callback needs the serial ones to count the freed objects of each type
+static bool ManagedHeap__use_workers(ManagedHeap* self, ManagedHeapSwpetInfo* out_info) {
+#if PK_ENABLE_THREADS
+    if(self->gc_workers == NULL || out_info != NULL) return false;
+    size_t arena_count = MultiPool__total_allocated_bytes(&self->small_objects) / kPoolArenaSize;
+    return arena_count >= PK_GC_PARALLEL_MIN_ARENAS;
+#else
+    return false;
+#endif
+}
 
-    ManagedHeap__mark(self);
-    if(out_info) out_info->mark_end_ns = time_ns();
-    int freed = ManagedHeap__sweep(self, out_info);
-    if(out_info) out_info->swpet_end_ns = time_ns();
+void ManagedHeap__set_threads(ManagedHeap* self, int n) {
+#if PK_ENABLE_THREADS
+    // the calling thread is one of them
+    int length = c11__max(n - 1, 0);
+    if(self->gc_workers != NULL) {
+        if(self->gc_workers->length == length) return;
+        c11_thrdpool__dtor(self->gc_workers);
+        PK_FREE(self->gc_workers);
+        self->gc_workers = NULL;
+    }
+    if(length > 0) {
+        self->gc_workers = PK_MALLOC(sizeof(c11_thrdpool));
+        c11_thrdpool__ctor(self->gc_workers, length);
+    }
+#endif
+}
 
-    // adjust `gc_threshold` based on `freed_ma`
-    self->freed_ma[0] = self->freed_ma[1];
-    self->freed_ma[1] = self->freed_ma[2];
-    self->freed_ma[2] = freed;
-    int avg_freed = (self->freed_ma[0] + self->freed_ma[1] + self->freed_ma[2]) / 3;
-    const int upper = PK_GC_MIN_THRESHOLD * 8;
-    const int lower = PK_GC_MIN_THRESHOLD / 2;
-    float free_ratio = (float)avg_freed / self->gc_threshold;
-    int new_threshold = self->gc_threshold * (1.5f / free_ratio);
-    if(out_info) {
-        out_info->auto_thres.before = self->gc_threshold;
-        out_info->auto_thres.after = new_threshold;
-        out_info->auto_thres.upper = upper;
-        out_info->auto_thres.lower = lower;
-        out_info->auto_thres.avg_freed = avg_freed;
-        out_info->auto_thres.free_ratio = free_ratio;
+static int ManagedHeap__sweep_large(ManagedHeap* self,
+                                    ManagedHeapSwpetInfo* out_info,
+                                    bool young_only,
+                                    bool promote) {
+    int i = young_only ? self->large_young_begin : 0;
+    int large_living_count = i;
+    int young_begin = -1;
+    for(; i < self->large_objects.length; i++) {
+        if(i == self->large_young_begin) young_begin = large_living_count;
+        PyObject* obj = c11__getitem(PyObject*, &self->large_objects, i);
+        if(obj->gc_marked & PK_GC_MARKED) {
+            obj->gc_marked &= ~PK_GC_MARKED;
+            if(promote) obj->gc_marked |= PK_GC_OLD;
+            c11__setitem(PyObject*, &self->large_objects, large_living_count, obj);
+            large_living_count++;
+        } else {
+            if(out_info) out_info->large_types[obj->type]++;
+            PyObject__dtor(obj);
+            LargePool__dealloc(&self->large_pool, obj, obj->size_8b);
+        }
     }
-    self->gc_threshold = c11__min(c11__max(new_threshold, lower), upper);
+    if(young_begin < 0) young_begin = large_living_count;
+    self->large_young_begin = promote ? large_living_count : young_begin;
+    // shrink `self->large_objects`
+    int large_freed = self->large_objects.length - large_living_count;
+    self->large_objects.length = large_living_count;
+    return large_freed;
+}
 
-    if(!py_isnone(&self->debug_callback)) {
-        ManagedHeap__fire_debug_callback_stop(self, out_info);
-        ManagedHeapSwpetInfo__delete(out_info);
+static int ManagedHeap__sweep_young(ManagedHeap* self, ManagedHeapSwpetInfo* out_info) {
+    bool promote = ManagedHeap__can_promote(self);
+    int small_freed = MultiPool__sweep_young(&self->small_objects,
+                                             out_info ? out_info->small_types : NULL,
+                                             promote);
+    int large_freed = ManagedHeap__sweep_large(self, out_info, true, promote);
+    // old objects are not swept, unmark them
+    c11__foreach(PyObject*, &self->old_marked, p) { (*p)->gc_marked &= ~PK_GC_MARKED; }
+    self->old_marked.length = 0;
+    c11__foreach(PyObject*, &self->remembered, p) {
+        (*p)->gc_marked &= promote ? ~(PK_GC_MARKED | PK_GC_REMEMBERED) : ~PK_GC_MARKED;
+    }
+    int freed = small_freed + large_freed;
+    self->gc_young_count = c11__max(self->gc_young_count - freed, 0);
+    if(promote) {
+        // no old object points to a young one now
+        self->remembered.length = 0;
+        self->gc_old_counter += self->gc_young_count;
+        self->gc_young_count = 0;
+    }
+    if(out_info) {
+        out_info->small_freed = small_freed;
+        out_info->large_freed = large_freed;
     }
     return freed;
 }
 
-int ManagedHeap__collect(ManagedHeap* self) {
+static int ManagedHeap__collect_lazy(ManagedHeap* self);
+
+static int ManagedHeap__run(ManagedHeap* self, bool minor, bool auto_thres) {
     self->gc_counter = 0;
 
     ManagedHeapSwpetInfo* out_info = NULL;
     if(!py_isnone(&self->debug_callback)) {
         out_info = ManagedHeapSwpetInfo__new();
+        out_info->is_minor = minor;
         ManagedHeap__fire_debug_callback_start(self);
     }
 
-    ManagedHeap__mark(self);
-    if(out_info) out_info->mark_end_ns = time_ns();
-    int freed = ManagedHeap__sweep(self, out_info);
+    int freed;
+    if(minor) {
+        ManagedHeap__mark_young(self);
+        if(out_info) out_info->mark_end_ns = time_ns();
+        freed = ManagedHeap__sweep_young(self, out_info);
+    } else if(auto_thres && !ManagedHeap__use_workers(self, NULL) && out_info == NULL) {
+        // automatic full collections leave the arenas to the allocator
+        freed = ManagedHeap__collect_lazy(self);
+    } else {
+#if PK_ENABLE_THREADS
+        if(ManagedHeap__use_workers(self, out_info)) {
+            ManagedHeap__mark_parallel(self, self->gc_workers);
+        } else {
+            ManagedHeap__mark(self);
+        }
+#else
+        ManagedHeap__mark(self);
+#endif
+        if(out_info) out_info->mark_end_ns = time_ns();
+        freed = ManagedHeap__sweep(self, out_info);
+    }
     if(out_info) out_info->swpet_end_ns = time_ns();
 
-    if(out_info) {
+    if(auto_thres) {
+        // adjust `gc_threshold` based on `freed_ma`
+        self->freed_ma[0] = self->freed_ma[1];
+        self->freed_ma[1] = self->freed_ma[2];
+        self->freed_ma[2] = freed;
+        int avg_freed = (self->freed_ma[0] + self->freed_ma[1] + self->freed_ma[2]) / 3;
+        const int upper = PK_GC_MIN_THRESHOLD * 8;
+        const int lower = PK_GC_MIN_THRESHOLD / 2;
+        float free_ratio = (float)avg_freed / self->gc_threshold;
+        int new_threshold = self->gc_threshold * (1.5f / free_ratio);
+        if(out_info) {
+            out_info->auto_thres.before = self->gc_threshold;
+            out_info->auto_thres.after = new_threshold;
+            out_info->auto_thres.upper = upper;
+            out_info->auto_thres.lower = lower;
+            out_info->auto_thres.avg_freed = avg_freed;
+            out_info->auto_thres.free_ratio = free_ratio;
+        }
+        self->gc_threshold = c11__min(c11__max(new_threshold, lower), upper);
+    } else if(out_info) {
         out_info->auto_thres.before = self->gc_threshold;
         out_info->auto_thres.after = self->gc_threshold;
     }
@@ -194,62 +299,273 @@ int ManagedHeap__collect(ManagedHeap* self) {
     return freed;
 }
 
-int ManagedHeap__sweep(ManagedHeap* self, ManagedHeapSwpetInfo* out_info) {
-    // small_objects
-    int small_freed =
-        MultiPool__sweep_dealloc(&self->small_objects, out_info ? out_info->small_types : NULL);
-    // large_objects
-    int large_living_count = 0;
-    for(int i = 0; i < self->large_objects.length; i++) {
-        PyObject* obj = c11__getitem(PyObject*, &self->large_objects, i);
-        if(obj->gc_marked & 0b01) {
-            obj->gc_marked &= 0b10;
-            c11__setitem(PyObject*, &self->large_objects, large_living_count, obj);
-            large_living_count++;
+// the roots and the objects written meanwhile are traced again at once
+static void ManagedHeap__end_mark(ManagedHeap* self) {
+    // they were counted when traced for the first time
+    self->gc_cycle_marked -= self->gray_again.length;
+    c11_vector__extend(&self->gc_roots, self->gray_again.data, self->gray_again.length);
+    self->gray_again.length = 0;
+    ManagedHeap__mark_roots(self);
+    ManagedHeap__mark_until(self, INT64_MAX);
+}
+
+static void ManagedHeap__begin_sweep(ManagedHeap* self) {
+    bool promote = ManagedHeap__can_promote(self);
+    // all survivors are promoted, forget remembered objects unless C functions may hold them
+    int remembered_count = 0;
+    c11__foreach(PyObject*, &self->remembered, p) {
+        if(promote || !((*p)->gc_marked & PK_GC_MARKED)) {
+            (*p)->gc_marked &= ~PK_GC_REMEMBERED;
+        } else {
+            c11__setitem(PyObject*, &self->remembered, remembered_count, *p);
+            remembered_count++;
+        }
+    }
+    self->remembered.length = remembered_count;
+    // every object is marked at most once, the others are garbage
+    int count = MultiPool__count(&self->small_objects) + self->large_objects.length;
+    self->gc_cycle_freed = count - self->gc_cycle_marked;
+    MultiPool__sweep_begin(&self->small_objects);
+    self->large_sweep_index = 0;
+    self->large_sweep_live = 0;
+    self->large_sweep_end = self->large_objects.length;
+    self->gc_young_count = 0;
+    self->gc_phase = ManagedHeapPhase_SWEEP;
+}
+
+// move the large objects allocated during the sweep after the survivors
+static void ManagedHeap__compact_large(ManagedHeap* self) {
+    PyObject** p = self->large_objects.data;
+    int tail = self->large_objects.length - self->large_sweep_end;
+    memmove(p + self->large_sweep_live, p + self->large_sweep_end, tail * sizeof(PyObject*));
+    self->large_objects.length = self->large_sweep_live + tail;
+    self->large_sweep_index = self->large_sweep_live;
+    self->large_sweep_end = self->large_sweep_live;
+}
+
+static void ManagedHeap__end_cycle(ManagedHeap* self) {
+    ManagedHeap__compact_large(self);
+    self->large_young_begin = self->large_sweep_live;
+
+    self->gc_phase = ManagedHeapPhase_IDLE;
+    self->gc_old_counter = 0;
+    int living_count = MultiPool__count(&self->small_objects) + self->large_objects.length;
+    self->gc_old_threshold = c11__max(living_count, PK_GC_MIN_THRESHOLD);
+}
+
+// sweep up to `count` large objects, returns true if all of them are swept
+static bool ManagedHeap__sweep_large_some(ManagedHeap* self, c11_vector* remembered, int count) {
+    int end = c11__min(self->large_sweep_index + count, self->large_sweep_end);
+    for(; self->large_sweep_index < end; self->large_sweep_index++) {
+        PyObject* obj = c11__getitem(PyObject*, &self->large_objects, self->large_sweep_index);
+        if(obj->gc_marked & PK_GC_MARKED) {
+            obj->gc_marked &= ~PK_GC_MARKED;
+            obj->gc_marked |= PK_GC_OLD;
+            if(remembered && !(obj->gc_marked & (PK_GC_REMEMBERED | PK_GC_UNTRACKED))) {
+                obj->gc_marked |= PK_GC_REMEMBERED;
+                c11_vector__push(PyObject*, remembered, obj);
+            }
+            c11__setitem(PyObject*, &self->large_objects, self->large_sweep_live, obj);
+            self->large_sweep_live++;
         } else {
-            if(out_info) out_info->large_types[obj->type]++;
-            self->large_total_size -= decode_size_8b(obj->size_8b);
             PyObject__dtor(obj);
-            PK_FREE(obj);
+            LargePool__dealloc(&self->large_pool, obj, obj->size_8b);
         }
     }
-    // shrink `self->large_objects`
-    int large_freed = self->large_objects.length - large_living_count;
-    self->large_objects.length = large_living_count;
+    return self->large_sweep_index == self->large_sweep_end;
+}
+
+// sweep a few arenas or large objects, returns true if the sweep is complete
+static bool ManagedHeap__sweep_some(ManagedHeap* self, c11_vector* remembered) {
+    if(!MultiPool__sweep_step(&self->small_objects, remembered)) return false;
+    return ManagedHeap__sweep_large_some(self, remembered, 64);
+}
+
+// complete the cycle in progress, returns the number of freed objects not reported yet
+static int ManagedHeap__finish_cycle(ManagedHeap* self) {
+    if(self->gc_phase == ManagedHeapPhase_IDLE) return 0;
+    if(self->gc_phase == ManagedHeapPhase_MARK) {
+        ManagedHeap__end_mark(self);
+        ManagedHeap__begin_sweep(self);
+    }
+    // C functions may hold the promoted objects, see `ManagedHeap__can_promote()`
+    c11_vector* remembered = ManagedHeap__can_promote(self) ? NULL : &self->remembered;
+    while(!ManagedHeap__sweep_some(self, remembered)) {}
+    ManagedHeap__end_cycle(self);
+    int freed = self->gc_cycle_freed;
+    self->gc_cycle_freed = 0;
+    return freed;
+}
+
+// mark at once but leave the arenas to `Pool__alloc()`, `ManagedHeap__step()` and
+// `ManagedHeap__finish_sweep()`, returns the number of objects to be freed
+static int ManagedHeap__collect_lazy(ManagedHeap* self) {
+    self->gc_cycle_marked = 0;
+    self->gc_phase = ManagedHeapPhase_MARK;
+    ManagedHeap__end_mark(self);
+    ManagedHeap__begin_sweep(self);
+    // give the memory of large objects back at once
+    ManagedHeap__sweep_large_some(self, NULL, INT_MAX);
+    ManagedHeap__compact_large(self);
+    int freed = self->gc_cycle_freed;
+    self->gc_cycle_freed = 0;
+    return freed;
+}
+
+bool ManagedHeap__step(ManagedHeap* self, int budget_us) {
+    // objects traced by a step may be written by C functions without the write barrier
+    if(!ManagedHeap__can_promote(self)) return false;
+    int64_t deadline = time_ns() + (int64_t)budget_us * 1000;
+    switch(self->gc_phase) {
+        case ManagedHeapPhase_IDLE: {
+            if(self->gc_counter < self->gc_threshold) return false;
+            self->gc_counter = 0;
+            self->gc_cycle_marked = 0;
+            self->gc_phase = ManagedHeapPhase_MARK;
+            ManagedHeap__mark_roots(self);
+        }
+        // fallthrough
+        case ManagedHeapPhase_MARK: {
+            if(!ManagedHeap__mark_until(self, deadline)) return false;
+            ManagedHeap__end_mark(self);
+            ManagedHeap__begin_sweep(self);
+        }
+        // fallthrough
+        case ManagedHeapPhase_SWEEP: {
+            do {
+                if(ManagedHeap__sweep_some(self, NULL)) {
+                    ManagedHeap__end_cycle(self);
+                    return true;
+                }
+            } while(time_ns() < deadline);
+            return false;
+        }
+    }
+    return false;
+}
+
+bool ManagedHeap__finish_sweep(ManagedHeap* self) {
+    if(self->gc_phase != ManagedHeapPhase_SWEEP) return false;
+    ManagedHeap__finish_cycle(self);
+    return true;
+}
+
+int ManagedHeap__collect_hint(ManagedHeap* self) {
+    if(self->gc_counter < self->gc_threshold) return 0;
+    // an unfinished mark completes the cycle instead
+    if(self->gc_phase == ManagedHeapPhase_MARK) {
+        self->gc_counter = 0;
+        return ManagedHeap__finish_cycle(self);
+    }
+    int freed = ManagedHeap__finish_cycle(self);
+    // collect the old generation once it has grown by `gc_old_threshold` objects
+    bool minor = !ManagedHeap__can_promote(self) || self->gc_old_counter < self->gc_old_threshold;
+    return freed + ManagedHeap__run(self, minor, true);
+}
+
+int ManagedHeap__collect(ManagedHeap* self) {
+    int freed = ManagedHeap__finish_cycle(self);
+    return freed + ManagedHeap__run(self, false, false);
+}
+
+int ManagedHeap__collect_young(ManagedHeap* self) {
+    // an unfinished mark collects the young objects as well
+    if(self->gc_phase == ManagedHeapPhase_MARK) return ManagedHeap__finish_cycle(self);
+    int freed = ManagedHeap__finish_cycle(self);
+    return freed + ManagedHeap__run(self, true, false);
+}
+
+static int ManagedHeap__sweep_small_parallel(ManagedHeap* self, bool promote) {
+#if PK_ENABLE_THREADS
+    // builtin dtors only free memory, the others may use the vm of this thread
+    VM* vm = pk_current_vm;
+    py_Dtor list_dtor = c11__getitem(TypePointer, &vm->types, tp_list).dtor;
+    py_Dtor dict_dtor = c11__getitem(TypePointer, &vm->types, tp_dict).dtor;
+    PoolSweepType* types = PK_MALLOC(sizeof(PoolSweepType) * vm->types.length);
+    for(int i = 0; i < vm->types.length; i++) {
+        py_Dtor dtor = c11__getitem(TypePointer, &vm->types, i).dtor;
+        types[i].dtor = dtor;
+        types[i].deferred = dtor != NULL && dtor != list_dtor && dtor != dict_dtor;
+    }
+    int freed = MultiPool__sweep_dealloc_parallel(&self->small_objects,
+                                                  self->gc_workers,
+                                                  types,
+                                                  promote);
+    PK_FREE(types);
+    return freed;
+#else
+    return MultiPool__sweep_dealloc(&self->small_objects, NULL, promote);
+#endif
+}
+
+int ManagedHeap__sweep(ManagedHeap* self, ManagedHeapSwpetInfo* out_info) {
+    bool promote = ManagedHeap__can_promote(self);
+    // forget remembered objects that are dead or about to be promoted with their children
+    int remembered_count = 0;
+    c11__foreach(PyObject*, &self->remembered, p) {
+        if(promote || !((*p)->gc_marked & PK_GC_MARKED)) {
+            (*p)->gc_marked &= ~PK_GC_REMEMBERED;
+        } else {
+            c11__setitem(PyObject*, &self->remembered, remembered_count, *p);
+            remembered_count++;
+        }
+    }
+    self->remembered.length = remembered_count;
+    // small_objects
+    int small_freed;
+    if(ManagedHeap__use_workers(self, out_info)) {
+        small_freed = ManagedHeap__sweep_small_parallel(self, promote);
+    } else {
+        small_freed = MultiPool__sweep_dealloc(&self->small_objects,
+                                               out_info ? out_info->small_types : NULL,
+                                               promote);
+    }
+    // large_objects
+    int large_freed = ManagedHeap__sweep_large(self, out_info, false, promote);
+    int freed = small_freed + large_freed;
+    self->gc_young_count = c11__max(self->gc_young_count - freed, 0);
+    if(promote) {
+        self->gc_young_count = 0;
+        self->gc_old_counter = 0;
+        int living_count = MultiPool__count(&self->small_objects) + self->large_objects.length;
+        self->gc_old_threshold = c11__max(living_count, PK_GC_MIN_THRESHOLD);
+    }
     if(out_info) {
         out_info->small_freed = small_freed;
         out_info->large_freed = large_freed;
     }
-    return small_freed + large_freed;
+    return freed;
 }
 
 PyObject* ManagedHeap__gcnew(ManagedHeap* self, py_Type type, int slots, int udsize) {
     assert(slots >= 0 || slots == -1);
     // header + slots + udsize
     int size = sizeof(PyObject) + PK_OBJ_SLOTS_SIZE(slots) + udsize;
-    PyObject* obj = MultiPool__alloc(&self->small_objects, size);
+    // C functions may hold the objects promoted by a lazy sweep, see `ManagedHeap__can_promote()`
+    c11_vector* remembered = ManagedHeap__can_promote(self) ? NULL : &self->remembered;
+    PyObject* obj = MultiPool__alloc(&self->small_objects, size, remembered);
     uint8_t size_8b = 0;
     if(obj == NULL) {
-        obj = PK_MALLOC(size);
-        int quantized_size;
-        size_8b = encode_size_8b(size, &quantized_size);
-        self->large_total_size += quantized_size;
+        obj = LargePool__alloc(&self->large_pool, size, &size_8b);
         c11_vector__push(PyObject*, &self->large_objects, obj);
+        obj->gc_marked = 0;  // pooled objects are initialized by `Pool__alloc()`
     }
     obj->type = type;
     obj->size_8b = size_8b;
-    obj->gc_marked = 0;
     obj->slots = slots;
 
     // initialize slots or dict
     if(slots >= 0) {
         memset(obj->flex, 0, slots * sizeof(py_TValue));
+    } else if(type == tp_type || type == tp_module) {
+        NameDict__ctor((void*)obj->flex, PK_TYPE_ATTR_LOAD_FACTOR);
     } else {
-        float load_factor = (type == tp_type || type == tp_module) ? PK_TYPE_ATTR_LOAD_FACTOR
-                                                                   : PK_INST_ATTR_LOAD_FACTOR;
-        NameDict__ctor((void*)obj->flex, load_factor);
+        py_TypeInfo* ti = pk_typeinfo(type);
+        if(ti->shape == NULL) ti->shape = InstanceShape__new_root();
+        NameDict__ctor_shaped((void*)obj->flex, ti->shape);
     }
 
     self->gc_counter++;
+    self->gc_young_count++;
     return obj;
 }
\ No newline at end of file
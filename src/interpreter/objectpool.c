@@ -2,97 +2,209 @@
 
 #include "pocketpy/objects/object.h"
 #include "pocketpy/common/sstream.h"
+#include "pocketpy/common/algorithm.h"
 
 #include <assert.h>
 #include <stdbool.h>
 #include <string.h>
+#include <limits.h>
 
-static PoolArena* PoolArena__new(int block_size) {
-    assert(kPoolArenaSize % block_size == 0);
-    int block_count = kPoolArenaSize / block_size;
-    PoolArena* self = PK_MALLOC(sizeof(PoolArena) + sizeof(int) * block_count);
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+// index of the lowest set bit, `x` must not be 0
+static int c11__ctz64(uint64_t x) {
+#if(defined(__clang__) || defined(__GNUC__))
+    return __builtin_ctzll(x);
+#elif defined(_MSC_VER) && defined(_WIN64)
+    unsigned long index;
+    _BitScanForward64(&index, x);
+    return (int)index;
+#else
+    int index = 0;
+    while((x & 1) == 0) {
+        index++;
+        x >>= 1;
+    }
+    return index;
+#endif
+}
+
+#define PoolArena__word_count(self) (((self)->block_count + 63) / 64)
+
+static PoolArena* PoolArena__new(int block_size, int data_size) {
+    // the tail of `data` is unused if `block_size` does not divide it
+    int block_count = data_size / block_size;
+    int word_count = (block_count + 63) / 64;
+    PoolArena* self = PK_MALLOC(sizeof(PoolArena) + sizeof(uint64_t) * word_count + data_size);
     self->block_size = block_size;
     self->block_count = block_count;
     self->unused_length = block_count;
-    for(int i = 0; i < block_count; i++) {
-        self->unused[i] = i;
-    }
-    memset(self->data, 0, kPoolArenaSize);
+    self->index = -1;
+    self->unused_hint = 0;
+    self->data_size = data_size;
+    self->data = (char*)(self->used + word_count);
+    memset(self->used, 0, sizeof(uint64_t) * word_count);
+    memset(self->data, 0, data_size);
     return self;
 }
 
+// take the lowest free block
 static void* PoolArena__alloc(PoolArena* self) {
     assert(self->unused_length > 0);
-    int index = self->unused[self->unused_length - 1];
+    uint64_t* used = self->used;
+    int w = self->unused_hint;
+    while(used[w] == UINT64_MAX)
+        w++;
+    self->unused_hint = w;
+    int index = w * 64 + c11__ctz64(~used[w]);
+    assert(index < self->block_count);
+    used[w] |= (uint64_t)1 << (index & 63);
     self->unused_length--;
     return self->data + index * self->block_size;
 }
 
-static int PoolArena__sweep_dealloc(PoolArena* self, int* out_types) {
-    int unused_length_before = self->unused_length;
-    self->unused_length = 0;
-    for(int i = 0; i < self->block_count; i++) {
-        PyObject* obj = (PyObject*)(self->data + i * self->block_size);
-        if(obj->type == 0) {
-            // free slot
-            self->unused[self->unused_length] = i;
-            self->unused_length++;
-        } else {
-            if(obj->gc_marked & 0b01) {
+static void PoolArena__free(PoolArena* self, int index) {
+    PyObject* obj = (PyObject*)(self->data + index * self->block_size);
+    obj->type = 0;
+    self->used[index / 64] &= ~((uint64_t)1 << (index & 63));
+    self->unused_length++;
+    self->unused_hint = c11__min(self->unused_hint, index / 64);
+}
+
+// `promote` makes the survivors old, `remembered` collects them if not NULL
+static int PoolArena__sweep_dealloc(PoolArena* self,
+                                    int* out_types,
+                                    bool promote,
+                                    c11_vector* remembered) {
+    int freed = 0;
+    int word_count = PoolArena__word_count(self);
+    for(int w = 0; w < word_count; w++) {
+        // only visit allocated blocks
+        uint64_t bits = self->used[w];
+        while(bits) {
+            int i = w * 64 + c11__ctz64(bits);
+            bits &= bits - 1;
+            PyObject* obj = (PyObject*)(self->data + i * self->block_size);
+            if(obj->gc_marked & PK_GC_GRAY) {
+                // allocated during an incremental sweep, keep it young
+                obj->gc_marked &= ~(PK_GC_MARKED | PK_GC_GRAY);
+            } else if(obj->gc_marked & PK_GC_MARKED) {
                 // marked, clear mark
-                obj->gc_marked &= 0b10;
+                obj->gc_marked &= ~PK_GC_MARKED;
+                if(promote) obj->gc_marked |= PK_GC_OLD;
+                if(remembered && !(obj->gc_marked & (PK_GC_REMEMBERED | PK_GC_UNTRACKED))) {
+                    obj->gc_marked |= PK_GC_REMEMBERED;
+                    c11_vector__push(PyObject*, remembered, obj);
+                }
             } else {
                 // not marked, need to free
                 if(out_types) out_types[obj->type]++;
                 PyObject__dtor(obj);
-                obj->type = 0;
-                self->unused[self->unused_length] = i;
-                self->unused_length++;
+                PoolArena__free(self, i);
+                freed++;
             }
         }
     }
-    return self->unused_length - unused_length_before;
+    return freed;
 }
 
 static void Pool__ctor(Pool* self, int block_size) {
     c11_vector__ctor(&self->arenas, sizeof(PoolArena*));
+    c11_vector__ctor(&self->young_blocks, sizeof(PoolYoungBlock));
     self->available_index = 0;
     self->block_size = block_size;
+    self->sweep_index = -1;
+    self->alloc_count = 0;
 }
 
 static void Pool__dtor(Pool* self) {
     for(int i = 0; i < self->arenas.length; i++) {
         PoolArena* arena = c11__getitem(PoolArena*, &self->arenas, i);
-        for(int i = 0; i < arena->block_count; i++) {
-            PyObject* obj = (PyObject*)(arena->data + i * self->block_size);
-            if(obj->type != 0) PyObject__dtor(obj);
+        for(int w = 0; w < PoolArena__word_count(arena); w++) {
+            uint64_t bits = arena->used[w];
+            while(bits) {
+                int j = w * 64 + c11__ctz64(bits);
+                bits &= bits - 1;
+                PyObject__dtor((PyObject*)(arena->data + j * self->block_size));
+            }
         }
         PK_FREE(arena);
     }
     c11_vector__dtor(&self->arenas);
+    c11_vector__dtor(&self->young_blocks);
 }
 
-static void* Pool__alloc(Pool* self) {
+static void Pool__sweep_next(Pool* self, c11_vector* remembered);
+
+static void* Pool__alloc(Pool* self, c11_vector* remembered) {
     PoolArena* arena;
-    if(self->available_index < self->arenas.length) {
-        arena = c11__getitem(PoolArena*, &self->arenas, self->available_index);
-    } else {
-        arena = PoolArena__new(self->block_size);
-        c11_vector__push(PoolArena*, &self->arenas, arena);
-        self->available_index = self->arenas.length - 1;
+    while(true) {
+        if(self->available_index < self->arenas.length) {
+            arena = c11__getitem(PoolArena*, &self->arenas, self->available_index);
+            if(arena->index == self->sweep_index) {
+                // blocks are only taken from swept arenas, sweep the next one on demand
+                Pool__sweep_next(self, remembered);
+                continue;
+            }
+            if(arena->unused_length > 0) break;
+            // a young sweep may leave full arenas after `available_index`
+            self->available_index++;
+        } else {
+            // double the size of the arenas up to `kPoolArenaSize`
+            int data_size = kPoolArenaMinSize;
+            for(int i = 0; i < self->arenas.length && data_size < kPoolArenaSize; i++) {
+                data_size *= 2;
+            }
+            arena = PoolArena__new(self->block_size, data_size);
+            arena->index = self->arenas.length;
+            c11_vector__push(PoolArena*, &self->arenas, arena);
+            self->available_index = arena->index;
+            break;
+        }
     }
     void* ptr = PoolArena__alloc(arena);
+    self->alloc_count++;
     if(arena->unused_length == 0) self->available_index++;
+    // keep it from the incremental sweep if its arena is not swept yet
+    bool unswept = self->sweep_index >= 0 && arena->index >= self->sweep_index;
+    ((PyObject*)ptr)->gc_marked = unswept ? (PK_GC_MARKED | PK_GC_GRAY) : 0;
+    PoolYoungBlock block = {arena, ptr};
+    c11_vector__push(PoolYoungBlock, &self->young_blocks, block);
     return ptr;
 }
 
-static int Pool__sweep_dealloc(Pool* self, int* out_types) {
-    PoolArena** p = self->arenas.data;
-
+// only visit the blocks allocated since the last promotion
+static int Pool__sweep_young(Pool* self, int* out_types, bool promote) {
+    PoolYoungBlock* p = self->young_blocks.data;
     int freed = 0;
-    for(int i = 0; i < self->arenas.length; i++) {
-        freed += PoolArena__sweep_dealloc(p[i], out_types);
+    int young_length = 0;
+    for(int i = 0; i < self->young_blocks.length; i++) {
+        PyObject* obj = p[i].ptr;
+        if(obj->gc_marked & PK_GC_MARKED) {
+            obj->gc_marked &= ~PK_GC_MARKED;
+            if(promote) {
+                obj->gc_marked |= PK_GC_OLD;
+            } else {
+                p[young_length++] = p[i];
+            }
+        } else {
+            PoolArena* arena = p[i].arena;
+            if(out_types) out_types[obj->type]++;
+            PyObject__dtor(obj);
+            PoolArena__free(arena, ((char*)obj - arena->data) / self->block_size);
+            self->available_index = c11__min(self->available_index, arena->index);
+            freed++;
+        }
     }
+    self->young_blocks.length = young_length;
+    return freed;
+}
+
+// reorder the arenas after all of them are swept
+static void Pool__sweep_finish(Pool* self, bool free_arenas) {
+    PoolArena** p = self->arenas.data;
 
     // move arenas with `unused_length == 0` to the front
     int j = 0;
@@ -116,10 +228,14 @@ static int Pool__sweep_dealloc(Pool* self, int* out_types) {
         }
     }
 
+    for(int i = 0; i < self->arenas.length; i++) {
+        p[i]->index = i;
+    }
+
     // free excess free arenas
     int free_quota = self->arenas.length / 2;
     int min_length = c11__max(free_quota, j + 1);
-    while(self->arenas.length > min_length) {
+    while(free_arenas && self->arenas.length > min_length) {
         PoolArena* back_arena = c11_vector__back(PoolArena*, &self->arenas);
         if(back_arena->unused_length == back_arena->block_count) {
             PK_FREE(back_arena);
@@ -132,45 +248,245 @@ static int Pool__sweep_dealloc(Pool* self, int* out_types) {
     // [[0, 0, 0, 0, 0, 1], 1, 1, 1, 2, 2]
     //                  ^j=5         ^k
     self->available_index = j;
+}
+
+// forget freed or promoted blocks, before their arenas are freed by `Pool__sweep_finish()`
+static void Pool__forget_young(Pool* self) {
+    PoolYoungBlock* young = self->young_blocks.data;
+    int young_length = 0;
+    for(int i = 0; i < self->young_blocks.length; i++) {
+        PyObject* obj = young[i].ptr;
+        if(obj->type != 0 && !(obj->gc_marked & PK_GC_OLD)) young[young_length++] = young[i];
+    }
+    self->young_blocks.length = young_length;
+}
+
+static int Pool__sweep_dealloc(Pool* self, int* out_types, bool promote) {
+    PoolArena** p = self->arenas.data;
+
+    int freed = 0;
+    for(int i = 0; i < self->arenas.length; i++) {
+        freed += PoolArena__sweep_dealloc(p[i], out_types, promote, NULL);
+    }
+
+    Pool__forget_young(self);
+    Pool__sweep_finish(self, true);
     return freed;
 }
 
-void* MultiPool__alloc(MultiPool* self, int size) {
+void* MultiPool__alloc(MultiPool* self, int size, c11_vector* remembered) {
     assert(size > 0);
-    int index = (size - 1) >> 5;
-    if(index < kMultiPoolCount) {
-        Pool* pool = &self->pools[index];
-        return Pool__alloc(pool);
+    if(size > PK_POOL_MAX_SIZE) return NULL;
+    Pool* pool = &self->pools[self->size_classes[(size - 1) / PK_POOL_SIZE_STEP]];
+    return Pool__alloc(pool, remembered);
+}
+
+int MultiPool__sweep_dealloc(MultiPool* self, int* out_types, bool promote) {
+    int freed = 0;
+    for(int i = 0; i < self->count; i++) {
+        Pool* item = &self->pools[i];
+        freed += Pool__sweep_dealloc(item, out_types, promote);
+    }
+    return freed;
+}
+
+int MultiPool__sweep_young(MultiPool* self, int* out_types, bool promote) {
+    int freed = 0;
+    for(int i = 0; i < self->count; i++) {
+        Pool* item = &self->pools[i];
+        freed += Pool__sweep_young(item, out_types, promote);
+    }
+    return freed;
+}
+
+// sweep `arenas[sweep_index]`, the sweep is finished after the last one
+static void Pool__sweep_next(Pool* self, c11_vector* remembered) {
+    if(self->sweep_index < self->arenas.length) {
+        PoolArena* arena = c11__getitem(PoolArena*, &self->arenas, self->sweep_index);
+        self->sweep_index++;
+        PoolArena__sweep_dealloc(arena, NULL, true, remembered);
+        self->available_index = c11__min(self->available_index, arena->index);
+    }
+    if(self->sweep_index == self->arenas.length) {
+        self->sweep_index = -1;
+        // returning memory to the system may take milliseconds, leave it to full collections
+        Pool__sweep_finish(self, false);
+    }
+}
+
+// an incremental or lazy sweep promotes all survivors, blocks allocated meanwhile are the young ones
+void MultiPool__sweep_begin(MultiPool* self) {
+    for(int i = 0; i < self->count; i++) {
+        Pool* item = &self->pools[i];
+        item->young_blocks.length = 0;
+        item->sweep_index = item->arenas.length > 0 ? 0 : -1;
+        item->available_index = 0;
     }
-    return NULL;
 }
 
-int MultiPool__sweep_dealloc(MultiPool* self, int* out_types) {
+// sweep the next arena, returns true if there is none
+bool MultiPool__sweep_step(MultiPool* self, c11_vector* remembered) {
+    for(int i = 0; i < self->count; i++) {
+        Pool* item = &self->pools[i];
+        if(item->sweep_index < 0) continue;
+        Pool__sweep_next(item, remembered);
+        return false;
+    }
+    return true;
+}
+
+#if PK_ENABLE_THREADS
+typedef struct ParallelSweep {
+    c11_vector /* PoolArena* */ arenas;
+    atomic_int next;  // index of the next arena to sweep
+    const PoolSweepType* types;
+    bool promote;
+    c11_mutex_t mutex;
+    c11_vector /* PoolYoungBlock */ deferred;  // dead objects with a deferred dtor
+} ParallelSweep;
+
+// like `PoolArena__sweep_dealloc()`, but dead objects of deferred types are kept allocated
+static void PoolArena__sweep_parallel(PoolArena* self, ParallelSweep* ctx, c11_vector* deferred) {
+    int word_count = PoolArena__word_count(self);
+    for(int w = 0; w < word_count; w++) {
+        uint64_t bits = self->used[w];
+        while(bits) {
+            int i = w * 64 + c11__ctz64(bits);
+            bits &= bits - 1;
+            PyObject* obj = (PyObject*)(self->data + i * self->block_size);
+            if(obj->gc_marked & PK_GC_MARKED) {
+                obj->gc_marked &= ~PK_GC_MARKED;
+                if(ctx->promote) obj->gc_marked |= PK_GC_OLD;
+                continue;
+            }
+            const PoolSweepType* type = &ctx->types[obj->type];
+            if(type->deferred) {
+                PoolYoungBlock block = {self, obj};
+                c11_vector__push(PoolYoungBlock, deferred, block);
+                continue;
+            }
+            if(type->dtor) type->dtor(PyObject__userdata_raw(obj));
+            if(obj->slots == -1) NameDict__dtor(PyObject__dict_raw(obj));
+            PoolArena__free(self, i);
+        }
+    }
+}
+
+static void ParallelSweep__run(void* arg) {
+    ParallelSweep* self = arg;
+    c11_vector deferred;
+    c11_vector__ctor(&deferred, sizeof(PoolYoungBlock));
+    while(true) {
+        int i = atomic_fetch_add_explicit(&self->next, 1, memory_order_relaxed);
+        if(i >= self->arenas.length) break;
+        PoolArena__sweep_parallel(c11__getitem(PoolArena*, &self->arenas, i), self, &deferred);
+    }
+    c11_mutex__lock(&self->mutex);
+    c11_vector__extend(&self->deferred, deferred.data, deferred.length);
+    c11_mutex__unlock(&self->mutex);
+    c11_vector__dtor(&deferred);
+}
+
+int MultiPool__sweep_dealloc_parallel(MultiPool* self,
+                                      c11_thrdpool* workers,
+                                      const PoolSweepType* types,
+                                      bool promote) {
+    ParallelSweep ctx;
+    c11_vector__ctor(&ctx.arenas, sizeof(PoolArena*));
+    atomic_store_explicit(&ctx.next, 0, memory_order_relaxed);
+    ctx.types = types;
+    ctx.promote = promote;
+    c11_mutex__ctor(&ctx.mutex);
+    c11_vector__ctor(&ctx.deferred, sizeof(PoolYoungBlock));
+
     int freed = 0;
-    for(int i = 0; i < kMultiPoolCount; i++) {
+    for(int i = 0; i < self->count; i++) {
         Pool* item = &self->pools[i];
-        freed += Pool__sweep_dealloc(item, out_types);
+        c11_vector__extend(&ctx.arenas, item->arenas.data, item->arenas.length);
+        c11__foreach(PoolArena*, &item->arenas, p) { freed -= (*p)->unused_length; }
     }
+
+    void** args = PK_MALLOC(sizeof(void*) * workers->length);
+    for(int i = 0; i < workers->length; i++) {
+        args[i] = &ctx;
+    }
+    c11_thrdpool__map(workers, ParallelSweep__run, args, workers->length);
+    ParallelSweep__run(&ctx);
+    c11_thrdpool__join(workers);
+    PK_FREE(args);
+
+    c11__foreach(PoolYoungBlock, &ctx.deferred, p) {
+        PyObject* obj = p->ptr;
+        PyObject__dtor(obj);
+        PoolArena__free(p->arena, ((char*)obj - p->arena->data) / p->arena->block_size);
+    }
+
+    for(int i = 0; i < self->count; i++) {
+        Pool* item = &self->pools[i];
+        c11__foreach(PoolArena*, &item->arenas, p) { freed += (*p)->unused_length; }
+        Pool__forget_young(item);
+        Pool__sweep_finish(item, true);
+    }
+
+    c11_vector__dtor(&ctx.arenas);
+    c11_mutex__dtor(&ctx.mutex);
+    c11_vector__dtor(&ctx.deferred);
     return freed;
 }
+#endif
+
+int MultiPool__count(MultiPool* self) {
+    int count = 0;
+    for(int i = 0; i < self->count; i++) {
+        Pool* item = &self->pools[i];
+        for(int j = 0; j < item->arenas.length; j++) {
+            PoolArena* arena = c11__getitem(PoolArena*, &item->arenas, j);
+            count += arena->block_count - arena->unused_length;
+        }
+    }
+    return count;
+}
+
+// block size of the size class after `size`
+static int MultiPool__next_size(int size) {
+    if(size < PK_POOL_FINE_MAX_SIZE) return size + PK_POOL_SIZE_STEP;
+    int step = (1 << (c11__bit_length(size) - 1)) / 4;
+    step = (step + PK_POOL_SIZE_STEP - 1) / PK_POOL_SIZE_STEP * PK_POOL_SIZE_STEP;
+    return c11__min(size + step, PK_POOL_MAX_SIZE);
+}
 
 void MultiPool__ctor(MultiPool* self) {
-    for(int i = 0; i < kMultiPoolCount; i++) {
-        Pool__ctor(&self->pools[i], 32 * (i + 1));
+    self->count = 1;
+    for(int size = PK_POOL_SIZE_STEP; size < PK_POOL_MAX_SIZE; size = MultiPool__next_size(size)) {
+        self->count++;
+    }
+    assert(self->count <= 256);
+    self->pools = PK_MALLOC(sizeof(Pool) * self->count);
+    int size = PK_POOL_SIZE_STEP;
+    for(int i = 0; i < self->count; i++) {
+        Pool__ctor(&self->pools[i], size);
+        size = MultiPool__next_size(size);
+    }
+    int index = 0;
+    for(int i = 0; i < c11__count_array(self->size_classes); i++) {
+        while(self->pools[index].block_size < (i + 1) * PK_POOL_SIZE_STEP)
+            index++;
+        self->size_classes[i] = (uint8_t)index;
     }
 }
 
 void MultiPool__dtor(MultiPool* self) {
-    for(int i = 0; i < kMultiPoolCount; i++) {
+    for(int i = 0; i < self->count; i++) {
         Pool__dtor(&self->pools[i]);
     }
+    PK_FREE(self->pools);
 }
 
 size_t MultiPool__total_allocated_bytes(MultiPool* self) {
     size_t total = 0;
-    for(int i = 0; i < kMultiPoolCount; i++) {
+    for(int i = 0; i < self->count; i++) {
         Pool* item = &self->pools[i];
-        total += (size_t)item->arenas.length * kPoolArenaSize;
+        c11__foreach(PoolArena*, &item->arenas, p) { total += (*p)->data_size; }
     }
     return total;
 }
@@ -178,33 +494,130 @@ size_t MultiPool__total_allocated_bytes(MultiPool* self) {
 c11_string* MultiPool__summary(MultiPool* self) {
     c11_sbuf sbuf;
     c11_sbuf__ctor(&sbuf);
-    int arena_count = 0;
+    long long total_size = 0;
     char buf[256];
-    for(int i = 0; i < kMultiPoolCount; i++) {
+    for(int i = 0; i < self->count; i++) {
         Pool* item = &self->pools[i];
-        arena_count += item->arenas.length;
-        int total_bytes = item->arenas.length * kPoolArenaSize;
+        if(item->alloc_count == 0) continue;
+        int total_bytes = 0;
         int used_bytes = 0;
         for(int j = 0; j < item->arenas.length; j++) {
             PoolArena* arena = c11__getitem(PoolArena*, &item->arenas, j);
+            total_bytes += arena->data_size;
             used_bytes += (arena->block_count - arena->unused_length) * arena->block_size;
         }
+        total_size += total_bytes;
         float used_pct = (float)used_bytes / total_bytes * 100;
         if(total_bytes == 0) used_pct = 0.0f;
         snprintf(buf,
                  sizeof(buf),
-                 "Pool %3d: len(arenas)=%d (%d full), size=%d/%d (%.1f%% used)\n",
+                 "Pool %4d: len(arenas)=%d (%d full), size=%d/%d (%.1f%% used), allocs=%lld\n",
                  item->block_size,
                  item->arenas.length,
                  item->available_index,
                  used_bytes,
                  total_bytes,
-                 used_pct);
+                 used_pct,
+                 (long long)item->alloc_count);
         c11_sbuf__write_cstr(&sbuf, buf);
     }
-    long long total_size = arena_count * kPoolArenaSize;
     double total_size_mb = (long long)(total_size / 1024) / 1024.0;
     snprintf(buf, sizeof(buf), "Total: %.2f MB\n", total_size_mb);
     c11_sbuf__write_cstr(&sbuf, buf);
     return c11_sbuf__submit(&sbuf);
 }
+
+// the smallest class of `size`, the classes of a doubling are `1 << d` plus 1 to 4 quarters
+static int LargePool__class(LargePool* self, int size) {
+    assert(size > PK_POOL_MAX_SIZE);
+    int d = c11__bit_length(size - 1) - 1;
+    int quarter = 1 << (d - 2);
+    int n = (size - (1 << d) + quarter - 1) / quarter;
+    return (d - self->min_shift) * 4 + n - 1;
+}
+
+static size_t LargePool__class_size(LargePool* self, int cls) {
+    int d = self->min_shift + cls / 4;
+    return ((size_t)1 << d) + (cls % 4 + 1) * ((size_t)1 << (d - 2));
+}
+
+void* LargePool__alloc(LargePool* self, int size, uint8_t* out_class) {
+    int cls = LargePool__class(self, size);
+    size_t block_size = LargePool__class_size(self, cls);
+    *out_class = (uint8_t)cls;
+    self->live_count[cls]++;
+    self->alloc_count[cls]++;
+    self->total_size += block_size;
+    if(cls >= self->cached_count) return PK_MALLOC(size);
+    c11_vector* blocks = &self->free_blocks[cls];
+    if(blocks->length > 0) {
+        self->free_size -= block_size;
+        void* ptr = c11_vector__back(void*, blocks);
+        c11_vector__pop(blocks);
+        return ptr;
+    }
+    return PK_MALLOC(block_size);
+}
+
+void LargePool__dealloc(LargePool* self, void* ptr, uint8_t cls) {
+    size_t block_size = LargePool__class_size(self, cls);
+    self->live_count[cls]--;
+    self->total_size -= block_size;
+    if(cls >= self->cached_count || self->free_size + block_size > kLargePoolMaxFreeSize) {
+        PK_FREE(ptr);
+        return;
+    }
+    self->free_size += block_size;
+    c11_vector__push(void*, &self->free_blocks[cls], ptr);
+}
+
+void LargePool__ctor(LargePool* self) {
+    self->min_shift = c11__bit_length(PK_POOL_MAX_SIZE) - 1;
+    self->count = LargePool__class(self, INT_MAX) + 1;
+    assert(self->count <= 256);
+    self->live_count = PK_MALLOC(sizeof(int) * self->count);
+    self->alloc_count = PK_MALLOC(sizeof(int64_t) * self->count);
+    for(int i = 0; i < self->count; i++) {
+        self->live_count[i] = 0;
+        self->alloc_count[i] = 0;
+    }
+    self->cached_count = 0;
+    if(PK_LARGE_POOL_MAX_SIZE > PK_POOL_MAX_SIZE) {
+        self->cached_count = LargePool__class(self, PK_LARGE_POOL_MAX_SIZE) + 1;
+    }
+    self->free_blocks = PK_MALLOC(sizeof(c11_vector) * c11__max(self->cached_count, 1));
+    for(int i = 0; i < self->cached_count; i++) {
+        c11_vector__ctor(&self->free_blocks[i], sizeof(void*));
+    }
+    self->total_size = 0;
+    self->free_size = 0;
+}
+
+void LargePool__dtor(LargePool* self) {
+    for(int i = 0; i < self->cached_count; i++) {
+        c11__foreach(void*, &self->free_blocks[i], p) { PK_FREE(*p); }
+        c11_vector__dtor(&self->free_blocks[i]);
+    }
+    PK_FREE(self->free_blocks);
+    PK_FREE(self->live_count);
+    PK_FREE(self->alloc_count);
+}
+
+c11_string* LargePool__summary(LargePool* self) {
+    c11_sbuf sbuf;
+    c11_sbuf__ctor(&sbuf);
+    char buf[256];
+    for(int i = 0; i < self->count; i++) {
+        if(self->alloc_count[i] == 0) continue;
+        int free_length = i < self->cached_count ? self->free_blocks[i].length : 0;
+        snprintf(buf,
+                 sizeof(buf),
+                 "Pool %6lld: live=%d, free=%d, allocs=%lld\n",
+                 (long long)LargePool__class_size(self, i),
+                 self->live_count[i],
+                 free_length,
+                 (long long)self->alloc_count[i]);
+        c11_sbuf__write_cstr(&sbuf, buf);
+    }
+    return c11_sbuf__submit(&sbuf);
+}
@@ -21,6 +21,68 @@ PK_INLINE py_TypeInfo* pk_typeinfo(py_Type type) {
     return c11__getitem(TypePointer, &pk_current_vm->types, type).ti;
 }
 
+uint32_t py_TypeInfo__version(py_TypeInfo* self) {
+    if(self->version == 0) {
+        // a subclass is only tagged after its bases, see `py_TypeInfo__modified`
+        if(self->base_ti) py_TypeInfo__version(self->base_ti);
+        self->version = ++pk_current_vm->next_type_version;
+    }
+    return self->version;
+}
+
+void py_TypeInfo__modified(py_TypeInfo* self) {
+    // an untagged type never has tagged subclasses
+    if(self->version == 0) return;
+    self->version = 0;
+    VM* vm = pk_current_vm;
+    for(py_Type i = 1; i < vm->types.length; i++) {
+        py_TypeInfo* ti = c11__getitem(TypePointer, &vm->types, i).ti;
+        if(ti->version == 0) continue;
+        for(py_TypeInfo* p = ti->base_ti; p; p = p->base_ti) {
+            if(p == self) {
+                ti->version = 0;
+                break;
+            }
+        }
+    }
+}
+
+bool py_TypeInfo__apply_slots(py_TypeInfo* self) {
+    py_Ref slots = py_getdict(&self->self, py_name("__slots__"));
+    if(!slots || !self->is_python) return true;
+    // instances keep a `__dict__` if any base has one
+    int offset = self->base == tp_object ? 0 : self->base_ti->inst_slots;
+    if(offset < 0) return true;
+    py_TValue* names;
+    int length = py_isstr(slots) ? 1 : pk_arrayview(slots, &names);
+    if(length == -1) return TypeError("'__slots__' must be a str, list or tuple");
+    if(py_isstr(slots)) names = slots;
+    // the class statement and its decorators may both reach here
+    if(length > 0 && py_isstr(&names[0])) {
+        py_Ref first = py_getdict(&self->self, py_namev(py_tosv(&names[0])));
+        if(first && py_istype(first, tp_member_descriptor)) return true;
+    }
+    for(int i = 0; i < length; i++) {
+        if(!py_checkstr(&names[i])) return false;
+        if(c11__sveq2(py_tosv(&names[i]), "__dict__")) return true;
+    }
+    for(int i = 0; i < length; i++) {
+        c11_sv sv = py_tosv(&names[i]);
+        if(c11__sveq2(sv, "__weakref__")) continue;
+        py_Name name = py_namev(sv);
+        if(py_getdict(&self->self, name)) {
+            return ValueError("'%n' in __slots__ conflicts with class variable", name);
+        }
+        py_TValue* descr = py_emplacedict(&self->self, name);
+        descr->type = tp_member_descriptor;
+        descr->is_ptr = false;
+        descr->extra = offset++;
+        descr->_ptr = name;
+    }
+    self->inst_slots = offset;
+    return true;
+}
+
 static void py_TypeInfo__common_init(py_Name name,
                                      py_Type base,
                                      py_Type index,
@@ -46,6 +108,11 @@ static void py_TypeInfo__common_init(py_Name name,
     if(!dtor && base) dtor = base_ti->dtor;
     self->is_python = is_python;
     self->is_final = is_final;
+    self->version = 0;
+    self->ctor_version = 0;
+    self->ctor_init = NULL;
+    // a subclass without `__slots__` keeps the layout of its base
+    self->inst_slots = is_python && base_ti ? base_ti->inst_slots : -1;
 
     self->getattribute = NULL;
     self->setattribute = NULL;
@@ -74,6 +141,7 @@ py_Type pk_newtype(const char* name,
                              is_final,
                              self,
                              py_retval());
+    self->shape = NULL;
     TypePointer* pointer = c11_vector__emplace(&pk_current_vm->types);
     pointer->ti = self;
     pointer->dtor = self->dtor;
@@ -1,6 +1,7 @@
 #include "pocketpy/interpreter/vm.h"
 #include "pocketpy/common/memorypool.h"
 #include "pocketpy/common/utils.h"
+#include "pocketpy/common/threads.h"
 #include "pocketpy/interpreter/generator.h"
 #include "pocketpy/interpreter/modules.h"
 #include "pocketpy/interpreter/typeinfo.h"
@@ -83,6 +84,9 @@ void VM__ctor(VM* self) {
     };
     BinTree__ctor(&self->modules, "", py_NIL(), &modules_config);
     c11_vector__ctor(&self->types, sizeof(TypePointer));
+    self->next_type_version = 0;
+    self->next_module_version = 0;
+    self->next_decl_uid = 0;
 
     self->builtins = NULL;
     self->main = NULL;
@@ -98,6 +102,7 @@ void VM__ctor(VM* self) {
 
     self->recursion_depth = 0;
     self->max_recursion_depth = 1000;
+    self->next_depth = -1;
 
     memset(self->reg, 0, sizeof(self->reg));
 
@@ -107,6 +112,8 @@ void VM__ctor(VM* self) {
 
     memset(&self->trace_info, 0, sizeof(TraceInfo));
     memset(&self->watchdog_info, 0, sizeof(WatchdogInfo));
+    memset(&self->budget_info, 0, sizeof(BudgetInfo));
+    self->is_instrumented = false;
     LineProfiler__ctor(&self->line_profiler);
 
     FixedMemoryPool__ctor(&self->pool_frame, sizeof(py_Frame), 32);
@@ -210,7 +217,6 @@ void VM__ctor(VM* self) {
     INJECT_BUILTIN_EXC(KeyError, tp_Exception);
 
 #undef INJECT_BUILTIN_EXC
-#undef validate
 
     /* Setup Public Builtin Types */
     py_Type public_types[] = {
@@ -246,6 +252,11 @@ void VM__ctor(VM* self) {
     pk__add_module_array2d();
     // pk__add_module_colorcvt();
 
+    // types appended to `py_PredefinedType` later than the ones above
+    validate(tp_task, pk_task__register());
+    validate(tp_member_descriptor, pk_member_descriptor__register());
+#undef validate
+
     // add modules
     pk__add_module_os();
     pk__add_module_sys();
@@ -301,6 +312,11 @@ void VM__dtor(VM* self) {
     // reset traceinfo
     py_sys_settrace(NULL, true);
     LineProfiler__dtor(&self->line_profiler);
+    // destroy shapes, objects do not need them in their destructors
+    for(py_Type i = 1; i < self->types.length; i++) {
+        py_TypeInfo* ti = c11__getitem(TypePointer, &self->types, i).ti;
+        if(ti->shape) InstanceShape__delete(ti->shape);
+    }
     // destroy all objects
     ManagedHeap__dtor(&self->heap);
     // clear frames
@@ -313,6 +329,10 @@ void VM__dtor(VM* self) {
     c11_vector__dtor(&self->types);
 }
 
+void VM__update_instrumentation(VM* self) {
+    self->is_instrumented = self->trace_info.func != NULL || self->budget_info.base_frame != NULL;
+}
+
 void VM__push_frame(VM* self, py_Frame* frame) {
     frame->f_back = self->top_frame;
     self->top_frame = frame;
@@ -324,8 +344,8 @@ void VM__pop_frame(VM* self) {
     assert(self->top_frame);
     py_Frame* frame = self->top_frame;
     if(self->trace_info.func) self->trace_info.func(frame, TRACE_EVENT_POP);
-    // reset stack pointer
-    self->stack.sp = frame->p0;
+    // reset stack pointer, also dropping the instance of an `__init__` frame
+    self->stack.sp = frame->p0 - (int)frame->is_ctor;
     // pop frame and delete
     self->top_frame = frame->f_back;
     Frame__delete(frame);
@@ -474,6 +494,34 @@ static bool
     return true;
 }
 
+// The `__init__` of a python class whose `__new__` is the default one can be called directly
+// on a new instance. It is resolved once per type version.
+static py_Ref resolve_ctor_init(py_TypeInfo* ti) {
+    uint32_t version = py_TypeInfo__version(ti);
+    if(ti->ctor_version == version) return ti->ctor_init;
+    ti->ctor_version = version;
+    ti->ctor_init = NULL;
+    if(!ti->is_python) return NULL;
+    py_Ref new_f = pk_tpfindmagic(ti, __new__);
+    if(new_f->type != tp_nativefunc || new_f->_cfunc != pk__object_new) return NULL;
+    py_Ref init_f = pk_tpfindmagic(ti, __init__);
+    if(!init_f || init_f->type != tp_function) return NULL;
+    Function* fn = py_touserdata(init_f);
+    if(fn->decl->type == FuncType_GENERATOR || fn->cfunc) return NULL;
+    ti->ctor_init = init_f;
+    return init_f;
+}
+
+bool VM__callcfunc(VM* self, py_CFunction f, int argc, py_Ref argv) {
+    // inside of `VM__run_frames()` the dispatch loop already counts as a C function
+    if(self->heap.run_depth > 0) return py_callcfunc(f, argc, argv);
+    // a native function entered from the host may hold pointers across its python calls
+    self->heap.run_depth++;
+    bool ok = py_callcfunc(f, argc, argv);
+    self->heap.run_depth--;
+    return ok;
+}
+
 FrameResult VM__vectorcall(VM* self, uint16_t argc, uint16_t kwargc, bool opcall) {
 #ifndef NDEBUG
     pk_print_stack(self, self->top_frame, (Bytecode){0});
@@ -492,7 +540,7 @@ FrameResult VM__vectorcall(VM* self, uint16_t argc, uint16_t kwargc, bool opcall
     // handle boundmethod, do a patch
     if(p0->type == tp_boundmethod) {
         assert(py_isnil(p0 + 1));  // self must be NULL
-        py_TValue* slots = PyObject__slots(p0->_obj);
+        py_TValue* slots = PyObject__slots_raw(p0->_obj);
         p0[0] = slots[1];  // callable
         p0[1] = slots[0];  // self
         // [unbound, self, args..., kwargs...]
@@ -502,7 +550,7 @@ FrameResult VM__vectorcall(VM* self, uint16_t argc, uint16_t kwargc, bool opcall
     self->curr_function = p0;  // set current function for inspection
 
     if(p0->type == tp_function) {
-        Function* fn = py_touserdata(p0);
+        Function* fn = PyObject__userdata_raw(p0->_obj);
         const CodeObject* co = &fn->decl->code;
 
         switch(fn->decl->type) {
@@ -519,7 +567,7 @@ FrameResult VM__vectorcall(VM* self, uint16_t argc, uint16_t kwargc, bool opcall
                     return opcall ? RES_CALL : VM__run_top_frame(self);
                 } else {
                     // decl-based binding
-                    bool ok = py_callcfunc(fn->cfunc, co->nlocals, argv);
+                    bool ok = VM__callcfunc(self, fn->cfunc, co->nlocals, argv);
                     self->stack.sp = p0;
                     return ok ? RES_RETURN : RES_ERROR;
                 }
@@ -546,7 +594,7 @@ FrameResult VM__vectorcall(VM* self, uint16_t argc, uint16_t kwargc, bool opcall
                     return opcall ? RES_CALL : VM__run_top_frame(self);
                 } else {
                     // decl-based binding
-                    bool ok = py_callcfunc(fn->cfunc, co->nlocals, argv);
+                    bool ok = VM__callcfunc(self, fn->cfunc, co->nlocals, argv);
                     self->stack.sp = p0;
                     return ok ? RES_RETURN : RES_ERROR;
                 }
@@ -573,13 +621,28 @@ FrameResult VM__vectorcall(VM* self, uint16_t argc, uint16_t kwargc, bool opcall
             TypeError("nativefunc does not accept keyword arguments");
             return RES_ERROR;
         }
-        bool ok = py_callcfunc(p0->_cfunc, p1 - argv, argv);
+        bool ok = VM__callcfunc(self, p0->_cfunc, p1 - argv, argv);
         self->stack.sp = p0;
         return ok ? RES_RETURN : RES_ERROR;
     }
 
     if(p0->type == tp_type) {
         // [cls, NULL, args..., kwargs...]
+        py_TypeInfo* ti = pk_typeinfo(py_totype(p0));
+        py_Ref ctor_init = resolve_ctor_init(ti);
+        if(ctor_init) {
+            // [instance, __init__, instance, args..., kwargs...]
+            //                ^p0
+            memmove(argv + 1, argv, (self->stack.sp - argv) * sizeof(py_TValue));
+            self->stack.sp++;
+            py_newobject(p0, ti->index, ti->inst_slots, 0);
+            p0[1] = *ctor_init;
+            p0[2] = p0[0];
+            if(VM__vectorcall(self, argc, kwargc, true) == RES_ERROR) return RES_ERROR;
+            self->top_frame->is_ctor = true;
+            return opcall ? RES_CALL : VM__run_top_frame(self);
+        }
+
         py_Ref new_f = py_tpfindmagic(py_totype(p0), __new__);
         assert(new_f && py_isnil(p0 + 1));
         bool is_default_new = new_f->type == tp_nativefunc && new_f->_cfunc == pk__object_new;
@@ -654,10 +717,89 @@ static void pk__mark_value_func(py_Ref val, void* ctx) {
     pk__mark_value(val);
 }
 
-void ManagedHeap__mark(ManagedHeap* self) {
+static void ManagedHeap__mark_children(PyObject* obj, c11_vector* p_stack) {
+    if(obj->slots > 0) {
+        py_TValue* p = PyObject__slots_raw(obj);
+        for(int i = 0; i < obj->slots; i++)
+            pk__mark_value(p + i);
+    } else if(obj->slots == -1) {
+        NameDict* dict = PyObject__dict_raw(obj);
+        if(NameDict__is_shaped(dict)) {
+            for(int i = 0; i < dict->length; i++) {
+                pk__mark_value(&dict->values[i]);
+            }
+        } else {
+            for(int i = 0; i < dict->capacity; i++) {
+                NameDict_KV* kv = &dict->items[i];
+                if(kv->key == NULL) continue;
+                pk__mark_value(&kv->value);
+            }
+        }
+    }
+
+    void* ud = PyObject__userdata_raw(obj);
+    switch(obj->type) {
+        case tp_list: {
+            List* self = ud;
+            for(int i = 0; i < self->length; i++) {
+                py_TValue* val = c11__at(py_TValue, self, i);
+                pk__mark_value(val);
+            }
+            break;
+        }
+        case tp_dict: {
+            Dict* self = ud;
+            for(int i = 0; i < self->entries.length; i++) {
+                DictEntry* entry = c11__at(DictEntry, &self->entries, i);
+                if(py_isnil(&entry->key)) continue;
+                pk__mark_value(&entry->key);
+                pk__mark_value(&entry->val);
+            }
+            break;
+        }
+        case tp_generator: {
+            Generator* self = ud;
+            if(self->frame) Frame__gc_mark(self->frame, p_stack);
+            for(int i = 0; i < self->backup_length; i++) {
+                pk__mark_value(&self->backup[i]);
+            }
+            break;
+        }
+        case tp_task: {
+            Task* self = ud;
+            for(py_Frame* f = self->frame; f; f = f->f_back) {
+                Frame__gc_mark(f, p_stack);
+            }
+            break;
+        }
+        case tp_function: {
+            function__gc_mark(ud, p_stack);
+            break;
+        }
+        case tp_BaseException: {
+            BaseException* self = ud;
+            pk__mark_value(&self->args);
+            pk__mark_value(&self->inner_exc);
+            c11__foreach(py_TValue, &self->snapshots, snapshot) {
+                pk__mark_value(snapshot);
+            }
+            break;
+        }
+        case tp_code: {
+            CodeObject* self = ud;
+            CodeObject__gc_mark(self, p_stack);
+            break;
+        }
+        case tp_chunked_array2d: {
+            c11_chunked_array2d__mark(ud, p_stack);
+            break;
+        }
+    }
+}
+
+void ManagedHeap__mark_roots(ManagedHeap* self) {
     VM* vm = pk_current_vm;
     c11_vector* p_stack = &self->gc_roots;
-    assert(p_stack->length == 0);
 
     // mark value stack
     for(py_TValue* p = vm->stack.begin; p < vm->stack.sp; p++) {
@@ -693,74 +835,153 @@ void ManagedHeap__mark(ManagedHeap* self) {
     pk__mark_value(&vm->heap.debug_callback);
     // mark user func
     if(vm->callbacks.gc_mark) vm->callbacks.gc_mark(pk__mark_value_func, p_stack);
-    /*****************************/
+}
+
+void ManagedHeap__mark(ManagedHeap* self) {
+    c11_vector* p_stack = &self->gc_roots;
+    assert(p_stack->length == 0);
+    ManagedHeap__mark_roots(self);
     while(p_stack->length > 0) {
         PyObject* obj = c11_vector__back(PyObject*, p_stack);
         c11_vector__pop(p_stack);
+        assert(obj->gc_marked & PK_GC_MARKED);
+        if(obj->gc_marked & PK_GC_UNTRACKED) continue;
+        ManagedHeap__mark_children(obj, p_stack);
+    }
+}
 
-        assert(obj->gc_marked & 0b01);
+// drain the gray objects of an incremental cycle, returns false if `deadline_ns` is reached first
+bool ManagedHeap__mark_until(ManagedHeap* self, int64_t deadline_ns) {
+    c11_vector* p_stack = &self->gc_roots;
+    int count = 0;
+    while(p_stack->length > 0) {
+        PyObject* obj = c11_vector__back(PyObject*, p_stack);
+        c11_vector__pop(p_stack);
+        assert(obj->gc_marked & PK_GC_MARKED);
+        obj->gc_marked &= ~PK_GC_GRAY;
+        if(!(obj->gc_marked & PK_GC_UNTRACKED)) ManagedHeap__mark_children(obj, p_stack);
+        if(++count % 64 == 0 && time_ns() >= deadline_ns) break;
+    }
+    self->gc_cycle_marked += count;
+    return p_stack->length == 0;
+}
 
-        if(obj->slots > 0) {
-            py_TValue* p = PyObject__slots(obj);
-            for(int i = 0; i < obj->slots; i++)
-                pk__mark_value(p + i);
-        } else if(obj->slots == -1) {
-            NameDict* dict = PyObject__dict(obj);
-            for(int i = 0; i < dict->capacity; i++) {
-                NameDict_KV* kv = &dict->items[i];
-                if(kv->key == NULL) continue;
-                pk__mark_value(&kv->value);
-            }
+#if PK_ENABLE_THREADS
+#define PK_GC_MARK_PACKET 256
+
+// gray objects are shared through `shared` in packets, each thread traces its own stack
+typedef struct ParallelMark {
+    c11_mutex_t mutex;
+    c11_vector /* PyObject_p */ shared;
+    int active;  // threads tracing a packet taken from `shared`
+    bool done;
+    atomic_int idle;  // threads waiting for `shared`
+} ParallelMark;
+
+// move a packet into `p_stack`, returns false if all threads are out of work
+static bool ParallelMark__take(ParallelMark* self, c11_vector* p_stack) {
+    atomic_fetch_add_explicit(&self->idle, 1, memory_order_relaxed);
+    c11_mutex__lock(&self->mutex);
+    while(self->shared.length == 0 && !self->done) {
+        if(self->active == 0) {
+            self->done = true;
+            break;
         }
+        c11_mutex__unlock(&self->mutex);
+        c11_thrd__yield();
+        c11_mutex__lock(&self->mutex);
+    }
+    atomic_fetch_sub_explicit(&self->idle, 1, memory_order_relaxed);
+    if(self->done) {
+        c11_mutex__unlock(&self->mutex);
+        return false;
+    }
+    int n = c11__min(self->shared.length, PK_GC_MARK_PACKET);
+    self->shared.length -= n;
+    c11_vector__extend(p_stack, c11__at(PyObject*, &self->shared, self->shared.length), n);
+    self->active++;
+    c11_mutex__unlock(&self->mutex);
+    return true;
+}
 
-        void* ud = PyObject__userdata(obj);
-        switch(obj->type) {
-            case tp_list: {
-                List* self = ud;
-                for(int i = 0; i < self->length; i++) {
-                    py_TValue* val = c11__at(py_TValue, self, i);
-                    pk__mark_value(val);
-                }
-                break;
-            }
-            case tp_dict: {
-                Dict* self = ud;
-                for(int i = 0; i < self->entries.length; i++) {
-                    DictEntry* entry = c11__at(DictEntry, &self->entries, i);
-                    if(py_isnil(&entry->key)) continue;
-                    pk__mark_value(&entry->key);
-                    pk__mark_value(&entry->val);
-                }
-                break;
-            }
-            case tp_generator: {
-                Generator* self = ud;
-                if(self->frame) Frame__gc_mark(self->frame, p_stack);
-                break;
-            }
-            case tp_function: {
-                function__gc_mark(ud, p_stack);
-                break;
-            }
-            case tp_BaseException: {
-                BaseException* self = ud;
-                pk__mark_value(&self->args);
-                pk__mark_value(&self->inner_exc);
-                c11__foreach(BaseExceptionFrame, &self->stacktrace, frame) {
-                    pk__mark_value(&frame->locals);
-                    pk__mark_value(&frame->globals);
-                }
-                break;
-            }
-            case tp_code: {
-                CodeObject* self = ud;
-                CodeObject__gc_mark(self, p_stack);
-                break;
-            }
-            case tp_chunked_array2d: {
-                c11_chunked_array2d__mark(ud, p_stack);
-                break;
+static void ParallelMark__run(void* arg) {
+    ParallelMark* self = arg;
+    c11_vector p_stack;
+    c11_vector__ctor(&p_stack, sizeof(PyObject*));
+    pk_gc_marking_parallel = true;
+    while(ParallelMark__take(self, &p_stack)) {
+        while(p_stack.length > 0) {
+            PyObject* obj = c11_vector__back(PyObject*, &p_stack);
+            c11_vector__pop(&p_stack);
+            uint8_t gc_marked =
+                atomic_load_explicit(PyObject__gc_marked_atomic(obj), memory_order_relaxed);
+            assert(gc_marked & PK_GC_MARKED);
+            if(!(gc_marked & PK_GC_UNTRACKED)) ManagedHeap__mark_children(obj, &p_stack);
+            // give a packet away if another thread is waiting
+            if(p_stack.length > 2 * PK_GC_MARK_PACKET &&
+               atomic_load_explicit(&self->idle, memory_order_relaxed) > 0) {
+                c11_mutex__lock(&self->mutex);
+                p_stack.length -= PK_GC_MARK_PACKET;
+                c11_vector__extend(&self->shared,
+                                   c11__at(PyObject*, &p_stack, p_stack.length),
+                                   PK_GC_MARK_PACKET);
+                c11_mutex__unlock(&self->mutex);
             }
         }
+        c11_mutex__lock(&self->mutex);
+        self->active--;
+        c11_mutex__unlock(&self->mutex);
+    }
+    pk_gc_marking_parallel = false;
+    c11_vector__dtor(&p_stack);
+}
+
+void ManagedHeap__mark_parallel(ManagedHeap* self, c11_thrdpool* workers) {
+    assert(self->gc_roots.length == 0);
+    ManagedHeap__mark_roots(self);
+
+    ParallelMark ctx;
+    c11_mutex__ctor(&ctx.mutex);
+    ctx.shared = self->gc_roots;
+    ctx.active = 0;
+    ctx.done = false;
+    atomic_store_explicit(&ctx.idle, 0, memory_order_relaxed);
+
+    void** args = PK_MALLOC(sizeof(void*) * workers->length);
+    for(int i = 0; i < workers->length; i++) {
+        args[i] = &ctx;
+    }
+    c11_thrdpool__map(workers, ParallelMark__run, args, workers->length);
+    ParallelMark__run(&ctx);
+    c11_thrdpool__join(workers);
+    PK_FREE(args);
+
+    // keep the buffer of `gc_roots`
+    self->gc_roots = ctx.shared;
+    assert(self->gc_roots.length == 0);
+    c11_mutex__dtor(&ctx.mutex);
+}
+#endif
+
+void ManagedHeap__mark_young(ManagedHeap* self) {
+    c11_vector* p_stack = &self->gc_roots;
+    assert(p_stack->length == 0);
+    // old objects written since the last promotion are roots as well
+    c11__foreach(PyObject*, &self->remembered, p) {
+        (*p)->gc_marked |= PK_GC_MARKED;
+        c11_vector__push(PyObject*, p_stack, *p);
+    }
+    ManagedHeap__mark_roots(self);
+    while(p_stack->length > 0) {
+        PyObject* obj = c11_vector__back(PyObject*, p_stack);
+        c11_vector__pop(p_stack);
+        assert(obj->gc_marked & PK_GC_MARKED);
+        if((obj->gc_marked & (PK_GC_OLD | PK_GC_REMEMBERED)) == PK_GC_OLD) {
+            // cannot point to young objects, only unmark it later
+            c11_vector__push(PyObject*, &self->old_marked, obj);
+            continue;
+        }
+        if(obj->gc_marked & PK_GC_UNTRACKED) continue;
+        ManagedHeap__mark_children(obj, p_stack);
     }
 }
@@ -121,13 +121,30 @@ py_Ref py_name2ref(py_Name name) {
 
 void PyObject__dtor(PyObject* self) {
     py_Dtor dtor = c11__getitem(TypePointer, &pk_current_vm->types, self->type).dtor;
-    if(dtor) dtor(PyObject__userdata(self));
+    if(dtor) dtor(PyObject__userdata_raw(self));
     if(self->slots == -1) {
-        NameDict* dict = PyObject__dict(self);
+        NameDict* dict = PyObject__dict_raw(self);
         NameDict__dtor(dict);
     }
 }
 
+void PyObject__write_barrier_slow(PyObject* self) {
+    ManagedHeap* heap = &pk_current_vm->heap;
+    bool marked = (self->gc_marked & (PK_GC_MARKED | PK_GC_GRAY)) == PK_GC_MARKED;
+    if(marked && heap->gc_phase == ManagedHeapPhase_MARK) {
+        // may be traced already, trace it again when the mark completes
+        self->gc_marked |= PK_GC_GRAY;
+        c11_vector__push(PyObject*, &heap->gray_again, self);
+    }
+    // marked objects are promoted when the incremental sweep reaches them
+    bool promoting = marked && heap->gc_phase == ManagedHeapPhase_SWEEP;
+    if(self->gc_marked & PK_GC_REMEMBERED) return;
+    if((self->gc_marked & PK_GC_OLD) || promoting) {
+        self->gc_marked |= PK_GC_REMEMBERED;
+        c11_vector__push(PyObject*, &heap->remembered, self);
+    }
+}
+
 ManagedHeapSwpetInfo* ManagedHeapSwpetInfo__new() {
     ManagedHeapSwpetInfo* self = py_malloc(sizeof(ManagedHeapSwpetInfo));
     memset(self, 0, sizeof(ManagedHeapSwpetInfo));
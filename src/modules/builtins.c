@@ -541,11 +541,8 @@ void function__gc_mark(void* ud, c11_vector* p_stack) {
     Function* func = ud;
     pk__mark_value(&func->globals);
     if(func->closure) {
-        NameDict* dict = func->closure;
-        for(int i = 0; i < dict->capacity; i++) {
-            NameDict_KV* kv = &dict->items[i];
-            if(kv->key == NULL) continue;
-            pk__mark_value(&kv->value);
+        for(int i = 0; i < func->decl->captures.length; i++) {
+            pk__mark_value(&func->closure[i]);
         }
     }
     FuncDecl__gc_mark(func->decl, p_stack);
@@ -20,6 +20,7 @@ static bool disassemble(CodeObject* co) {
     int prev_line = -1;
     for(int i = 0; i < co->codes.length; i++) {
         Bytecode byte = c11__getitem(Bytecode, &co->codes, i);
+        byte.op = Bytecode__base_op(&byte);  // hide quickened instructions
         BytecodeEx ex = c11__getitem(BytecodeEx, &co->codes_ex, i);
 
         char line[8] = "";
@@ -74,7 +75,6 @@ static bool disassemble(CodeObject* co) {
                 }
                 case OP_LOAD_NAME: case OP_LOAD_NAME_AS_INT:
                 case OP_LOAD_GLOBAL:
-                case OP_LOAD_NONLOCAL:
                 case OP_STORE_GLOBAL:
                 case OP_LOAD_ATTR:
                 case OP_LOAD_SELF_ATTR:
@@ -90,12 +90,24 @@ static bool disassemble(CodeObject* co) {
                     break;
                 }
                 case OP_LOAD_FAST:
+                case OP_LOAD_FAST_LOAD_FAST:
+                case OP_LOAD_FAST_LOAD_CONST:
+                case OP_LOAD_FAST_LOAD_ATTR:
                 case OP_STORE_FAST:
                 case OP_DELETE_FAST: {
                     py_Name name = c11__getitem(py_Name, &co->varnames, byte.arg);
                     pk_sprintf(&ss, " (%n)", name);
                     break;
                 }
+                case OP_LOAD_DEREF: {
+                    py_Name name = c11__getitem(py_Name, &co->freevars, byte.arg);
+                    pk_sprintf(&ss, " (%n)", name);
+                    break;
+                }
+                case OP_COMPARE_JUMP_IF_FALSE: {
+                    pk_sprintf(&ss, " (%s)", pk_opname(byte.arg));
+                    break;
+                }
                 case OP_LOAD_FUNCTION: {
                     const FuncDecl* decl = c11__getitem(FuncDecl*, &co->func_decls, byte.arg);
                     pk_sprintf(&ss, " (%s)", decl->code.name->data);
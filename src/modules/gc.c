@@ -25,9 +25,15 @@ static bool gc_isenabled(int argc, py_Ref argv) {
 }
 
 static bool gc_collect(int argc, py_Ref argv) {
-    PY_CHECK_ARGC(0);
+    py_i64 generation = 2;
+    if(argc > 1) return TypeError("collect() takes at most 1 argument");
+    if(argc == 1) {
+        PY_CHECK_ARG_TYPE(0, tp_int);
+        generation = py_toint(argv);
+        if(generation < 0 || generation > 2) return ValueError("invalid generation");
+    }
     ManagedHeap* heap = &pk_current_vm->heap;
-    int freed = ManagedHeap__collect(heap);
+    int freed = generation == 2 ? ManagedHeap__collect(heap) : ManagedHeap__collect_young(heap);
     py_newint(py_retval(), freed);
     return true;
 }
@@ -40,6 +46,32 @@ static bool gc_collect_hint(int argc, py_Ref argv) {
     return true;
 }
 
+static bool gc_step(int argc, py_Ref argv) {
+    PY_CHECK_ARGC(1);
+    PY_CHECK_ARG_TYPE(0, tp_int);
+    py_i64 budget_us = py_toint(argv);
+    if(budget_us < 0 || budget_us > INT32_MAX) return ValueError("invalid budget");
+    py_newbool(py_retval(), py_gc_step((int)budget_us));
+    return true;
+}
+
+static bool gc_finish_sweep(int argc, py_Ref argv) {
+    PY_CHECK_ARGC(0);
+    ManagedHeap* heap = &pk_current_vm->heap;
+    py_newbool(py_retval(), ManagedHeap__finish_sweep(heap));
+    return true;
+}
+
+static bool gc_set_threads(int argc, py_Ref argv) {
+    PY_CHECK_ARGC(1);
+    PY_CHECK_ARG_TYPE(0, tp_int);
+    py_i64 n = py_toint(argv);
+    if(n < 1 || n > 256) return ValueError("invalid number of threads");
+    py_gc_setthreads((int)n);
+    py_newnone(py_retval());
+    return true;
+}
+
 static bool gc_setup_debug_callback(int argc, py_Ref argv) {
     PY_CHECK_ARGC(1);
     ManagedHeap* heap = &pk_current_vm->heap;
@@ -54,7 +86,7 @@ static bool gc_is_tracked(int argc, py_Ref argv) {
         py_newbool(py_retval(), false);
         return true;
     }
-    bool res = !(argv->_obj->gc_marked & 0b10);
+    bool res = !(argv->_obj->gc_marked & PK_GC_UNTRACKED);
     py_newbool(py_retval(), res);
     return true;
 }
@@ -62,7 +94,10 @@ static bool gc_is_tracked(int argc, py_Ref argv) {
 static bool gc_track(int argc, py_Ref argv) {
     PY_CHECK_ARGC(1);
     if(!argv->is_ptr) return TypeError("gc.track() only accepts objects");
-    argv->_obj->gc_marked &= 0b01;
+    PyObject* obj = argv->_obj;
+    obj->gc_marked &= ~PK_GC_UNTRACKED;
+    // its children were not traced, they may be young
+    PyObject__write_barrier(obj);
     py_newnone(py_retval());
     return true;
 }
@@ -70,7 +105,7 @@ static bool gc_track(int argc, py_Ref argv) {
 static bool gc_untrack(int argc, py_Ref argv) {
     PY_CHECK_ARGC(1);
     if(!argv->is_ptr) return TypeError("gc.untrack() only accepts objects");
-    argv->_obj->gc_marked |= 0b10;
+    argv->_obj->gc_marked |= PK_GC_UNTRACKED;
     py_newnone(py_retval());
     return true;
 }
@@ -84,6 +119,9 @@ void pk__add_module_gc() {
 
     py_bindfunc(mod, "collect", gc_collect);
     py_bindfunc(mod, "collect_hint", gc_collect_hint);
+    py_bindfunc(mod, "step", gc_step);
+    py_bindfunc(mod, "finish_sweep", gc_finish_sweep);
+    py_bindfunc(mod, "set_threads", gc_set_threads);
     py_bindfunc(mod, "setup_debug_callback", gc_setup_debug_callback);
 
     py_bindfunc(mod, "is_tracked", gc_is_tracked);
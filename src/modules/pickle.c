@@ -214,6 +214,21 @@ static bool _check_function(Function* f) {
     return true;
 }
 
+// name of the `__slots__` member stored at `index`
+static py_Name pkl__member_name(py_TypeInfo* ti, int index) {
+    for(; ti; ti = ti->base_ti) {
+        NameDict* dict = PyObject__dict(ti->self._obj);
+        for(int i = 0; i < NameDict__end(dict); i++) {
+            py_Ref val = NameDict__value_at(dict, i);
+            if(NameDict__key_at(dict, i) == NULL) continue;
+            if(py_istype(val, tp_member_descriptor) && val->extra == index) {
+                return NameDict__key_at(dict, i);
+            }
+        }
+    }
+    c11__unreachable();
+}
+
 static bool pkl__write_object(PickleObject* buf, py_TValue* obj) {
     switch(obj->type) {
         case tp_nil: {
@@ -426,21 +441,44 @@ static bool pkl__write_object(PickleObject* buf, py_TValue* obj) {
                 pkl__store_memo(buf, obj->_obj);
                 return true;
             }
+            if(ti->is_python && obj->_obj->slots >= 0) {
+                // instances of a class with `__slots__`
+                py_TValue* slots = PyObject__slots(obj->_obj);
+                int length = 0;
+                for(int i = obj->_obj->slots - 1; i >= 0; i--) {
+                    if(py_isnil(&slots[i])) continue;
+                    if(!pkl__write_object(buf, &slots[i])) return false;
+                    length++;
+                }
+                pkl__emit_op(buf, PKL_OBJECT);
+                pkl__emit_int(buf, obj->type);
+                buf->used_types[obj->type] = true;
+                pkl__emit_int(buf, length);
+                for(int i = 0; i < obj->_obj->slots; i++) {
+                    if(py_isnil(&slots[i])) continue;
+                    c11_sv field = py_name2sv(pkl__member_name(ti, i));
+                    // include '\0'
+                    PickleObject__write_bytes(buf, field.data, field.size + 1);
+                }
+
+                // store memo
+                pkl__store_memo(buf, obj->_obj);
+                return true;
+            }
             if(ti->is_python) {
                 NameDict* dict = PyObject__dict(obj->_obj);
-                for(int i = dict->capacity - 1; i >= 0; i--) {
-                    NameDict_KV* kv = &dict->items[i];
-                    if(kv->key == NULL) continue;
-                    if(!pkl__write_object(buf, &kv->value)) return false;
+                for(int i = NameDict__end(dict) - 1; i >= 0; i--) {
+                    if(NameDict__key_at(dict, i) == NULL) continue;
+                    if(!pkl__write_object(buf, NameDict__value_at(dict, i))) return false;
                 }
                 pkl__emit_op(buf, PKL_OBJECT);
                 pkl__emit_int(buf, obj->type);
                 buf->used_types[obj->type] = true;
                 pkl__emit_int(buf, dict->length);
-                for(int i = 0; i < dict->capacity; i++) {
-                    NameDict_KV* kv = &dict->items[i];
-                    if(kv->key == NULL) continue;
-                    c11_sv field = py_name2sv(kv->key);
+                for(int i = 0; i < NameDict__end(dict); i++) {
+                    py_Name key = NameDict__key_at(dict, i);
+                    if(key == NULL) continue;
+                    c11_sv field = py_name2sv(key);
                     // include '\0'
                     PickleObject__write_bytes(buf, field.data, field.size + 1);
                 }
@@ -751,13 +789,22 @@ bool py_pickle_loads_body(const unsigned char* p, int memo_length, c11_smallmap_
             case PKL_OBJECT: {
                 py_Type type = (py_Type)pkl__read_int(&p);
                 type = pkl__fix_type(type, type_mapping);
-                py_newobject(py_retval(), type, -1, 0);
-                NameDict* dict = PyObject__dict(py_retval()->_obj);
+                py_TypeInfo* ti = pk_typeinfo(type);
+                py_newobject(py_retval(), type, ti->inst_slots, 0);
                 int dict_length = pkl__read_int(&p);
                 for(int i = 0; i < dict_length; i++) {
                     py_StackRef value = py_peek(-1);
                     c11_sv field = {(const char*)p, strlen((const char*)p)};
-                    NameDict__set(dict, py_namev(field), value);
+                    if(ti->inst_slots >= 0) {
+                        py_Ref descr = pk_tpfindname(ti, py_namev(field));
+                        if(!descr || !py_istype(descr, tp_member_descriptor) ||
+                           descr->extra >= ti->inst_slots) {
+                            return ValueError("invalid pickle data");
+                        }
+                        py_setslot(py_retval(), descr->extra, value);
+                    } else {
+                        NameDict__set(PyObject__dict(py_retval()->_obj), py_namev(field), value);
+                    }
                     py_pop();
                     p += field.size + 1;
                 }
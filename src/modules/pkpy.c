@@ -42,7 +42,7 @@ static bool pkpy_memory_usage(int argc, py_Ref argv) {
     PY_CHECK_ARGC(0);
     ManagedHeap* heap = &pk_current_vm->heap;
     py_i64 size = MultiPool__total_allocated_bytes(&heap->small_objects);
-    size += heap->large_total_size;
+    size += heap->large_pool.total_size;
     size += sizeof(VM);
     py_newint(py_retval(), size);
     return true;
@@ -52,6 +52,7 @@ static bool pkpy_memory_usage_info(int argc, py_Ref argv) {
     PY_CHECK_ARGC(0);
     ManagedHeap* heap = &pk_current_vm->heap;
     c11_string* small_objects_usage = MultiPool__summary(&heap->small_objects);
+    c11_string* large_objects_usage = LargePool__summary(&heap->large_pool);
     int large_object_count = heap->large_objects.length;
     c11_sbuf buf;
     c11_sbuf__ctor(&buf);
@@ -64,7 +65,8 @@ static bool pkpy_memory_usage_info(int argc, py_Ref argv) {
     c11_sbuf__write_cstr(&buf, small_objects_usage->data);
     c11_sbuf__write_cstr(&buf, "== heap.large_objects ==\n");
     pk_sprintf(&buf, "len(large_objects)=%d\n", large_object_count);
-    double large_total_size_mb = (size_t)(heap->large_total_size / 1024) / 1024.0;
+    c11_sbuf__write_cstr(&buf, large_objects_usage->data);
+    double large_total_size_mb = (size_t)(heap->large_pool.total_size / 1024) / 1024.0;
     c11_sbuf__write_cstr(&buf, "Total: ~");
     c11_sbuf__write_f64(&buf, large_total_size_mb, 2);
     c11_sbuf__write_cstr(&buf, " MB\n");
@@ -74,6 +76,7 @@ static bool pkpy_memory_usage_info(int argc, py_Ref argv) {
     // c11_sbuf__write_cstr(&buf, "== vm.pool_frame ==\n");
     c11_sbuf__py_submit(&buf, py_retval());
     c11_string__delete(small_objects_usage);
+    c11_string__delete(large_objects_usage);
     return true;
 }
 
@@ -86,12 +89,13 @@ static bool pkpy_currentvm(int argc, py_Ref argv) {
 #if PK_ENABLE_WATCHDOG
 void py_watchdog_begin(py_i64 timeout) {
     WatchdogInfo* info = &pk_current_vm->watchdog_info;
-    info->max_reset_time = clock() + (timeout * (CLOCKS_PER_SEC / 1000));
+    info->deadline = time_monotonic_ns() + timeout * 1000000;
+    info->countdown = PK_WATCHDOG_POLL_INTERVAL;
 }
 
 void py_watchdog_end() {
     WatchdogInfo* info = &pk_current_vm->watchdog_info;
-    info->max_reset_time = 0;
+    info->deadline = 0;
 }
 
 static bool pkpy_watchdog_begin(int argc, py_Ref argv) {
@@ -545,6 +549,7 @@ void pk__add_module_pkpy() {
     py_bindfunc(mod, "memory_usage_info", pkpy_memory_usage_info);
 
     py_bindfunc(mod, "currentvm", pkpy_currentvm);
+    py_setdict(mod, py_name("Task"), py_tpobject(tp_task));
 
 #if PK_ENABLE_WATCHDOG
     py_bindfunc(mod, "watchdog_begin", pkpy_watchdog_begin);
@@ -566,6 +571,7 @@ void pk__add_module_pkpy() {
     pkpy_configmacros_add(configmacros, "PK_ENABLE_THREADS", PK_ENABLE_THREADS);
     pkpy_configmacros_add(configmacros, "PK_ENABLE_DETERMINISM", PK_ENABLE_DETERMINISM);
     pkpy_configmacros_add(configmacros, "PK_ENABLE_WATCHDOG", PK_ENABLE_WATCHDOG);
+    pkpy_configmacros_add(configmacros, "PK_ENABLE_COMPUTED_GOTO", PK_ENABLE_COMPUTED_GOTO);
     pkpy_configmacros_add(configmacros, "PK_GC_MIN_THRESHOLD", PK_GC_MIN_THRESHOLD);
     pkpy_configmacros_add(configmacros, "PK_VM_STACK_SIZE", PK_VM_STACK_SIZE);
 }
@@ -6,9 +6,9 @@ static bool traceback_format_exc(int argc, py_Ref argv) {
     PY_CHECK_ARGC(0);
     VM* vm = pk_current_vm;
     if(vm->top_frame) {
-        FrameExcInfo* info = Frame__top_exc_info(vm->top_frame);
-        if(info && !py_isnil(&info->exc)) {
-            char* res = formatexc_internal(&info->exc);
+        py_Ref exc = Frame__handled_exc(vm->top_frame);
+        if(exc) {
+            char* res = formatexc_internal(exc);
             py_newstr(py_retval(), res);
             PK_FREE(res);
             return true;
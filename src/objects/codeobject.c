@@ -3,6 +3,7 @@
 #include "pocketpy/pocketpy.h"
 #include <stdint.h>
 #include <assert.h>
+#include <string.h>
 
 void Bytecode__set_signed_arg(Bytecode* self, int arg) {
     self->arg = (int16_t)arg;
@@ -12,15 +13,29 @@ void Bytecode__set_signed_arg(Bytecode* self, int arg) {
 }
 
 bool Bytecode__is_forward_jump(const Bytecode* self) {
-    Opcode op = self->op;
+    Opcode op = Bytecode__base_op(self);
     return (op >= OP_JUMP_FORWARD && op <= OP_LOOP_BREAK) ||
-           (op == OP_FOR_ITER || op == OP_FOR_ITER_YIELD_VALUE);
+           (op == OP_FOR_ITER || op == OP_FOR_RANGE || op == OP_FOR_RANGE_STORE_FAST ||
+            op == OP_FOR_ITER_YIELD_VALUE);
+}
+
+Opcode Bytecode__base_op(const Bytecode* self) {
+    switch(self->op) {
+        case OP_FOR_ITER_LIST:
+        case OP_FOR_ITER_TUPLE:
+        case OP_FOR_ITER_RANGE: return OP_FOR_ITER;
+        case OP_CALL_PY_EXACT_ARGS:
+        case OP_CALL_PY_PLANNED: return OP_CALL;
+        case OP_LOAD_SUBSCR_LIST_INT: return OP_LOAD_SUBSCR;
+        default: return self->op;
+    }
 }
 
 void FuncDecl__dtor(FuncDecl* self) {
     CodeObject__dtor(&self->code);
     c11_vector__dtor(&self->args);
     c11_vector__dtor(&self->kwargs);
+    c11_vector__dtor(&self->captures);
     c11_smallmap_n2d__dtor(&self->kw_to_index);
     if(self->docstring) py_free(self->docstring);
 }
@@ -37,11 +52,13 @@ FuncDecl_ FuncDecl__rcnew(SourceData_ src, c11_sv name) {
     self->starred_arg = -1;
     self->starred_kwarg = -1;
     self->nested = false;
+    c11_vector__ctor(&self->captures, sizeof(FuncDeclCapture));
 
     self->docstring = NULL;
     self->type = FuncType_UNSET;
 
     c11_smallmap_n2d__ctor(&self->kw_to_index);
+    self->uid = 0;
     return self;
 }
 
@@ -101,18 +118,22 @@ void CodeObject__ctor(CodeObject* self, SourceData_ src, c11_sv name) {
     c11_vector__ctor(&self->consts, sizeof(py_TValue));
     c11_vector__ctor(&self->varnames, sizeof(py_Name));
     c11_vector__ctor(&self->names, sizeof(py_Name));
+    c11_vector__ctor(&self->freevars, sizeof(py_Name));
     self->nlocals = 0;
 
     c11_smallmap_n2d__ctor(&self->varnames_inv);
     c11_smallmap_n2d__ctor(&self->names_inv);
 
     c11_vector__ctor(&self->blocks, sizeof(CodeBlock));
+    c11_vector__ctor(&self->handlers, sizeof(CodeHandler));
     c11_vector__ctor(&self->func_decls, sizeof(FuncDecl_));
 
     self->start_line = -1;
     self->end_line = -1;
 
-    CodeBlock root_block = {CodeBlockType_NO_BLOCK, -1, 0, -1, -1};
+    self->caches = NULL;
+
+    CodeBlock root_block = {CodeBlockType_NO_BLOCK, -1, 0, -1, -1, 0};
     c11_vector__push(CodeBlock, &self->blocks, root_block);
 }
 
@@ -120,17 +141,27 @@ void CodeObject__dtor(CodeObject* self) {
     PK_DECREF(self->src);
     c11_string__delete(self->name);
 
+    if(self->caches) {
+        for(int i = 0; i < self->codes.length; i++) {
+            Bytecode* byte = c11__at(Bytecode, &self->codes, i);
+            if(Bytecode__base_op(byte) == OP_CALL) PK_FREE(self->caches[i].plan);
+        }
+        PK_FREE(self->caches);
+    }
+
     c11_vector__dtor(&self->codes);
     c11_vector__dtor(&self->codes_ex);
 
     c11_vector__dtor(&self->consts);
     c11_vector__dtor(&self->varnames);
     c11_vector__dtor(&self->names);
+    c11_vector__dtor(&self->freevars);
 
     c11_smallmap_n2d__dtor(&self->varnames_inv);
     c11_smallmap_n2d__dtor(&self->names_inv);
 
     c11_vector__dtor(&self->blocks);
+    c11_vector__dtor(&self->handlers);
 
     for(int i = 0; i < self->func_decls.length; i++) {
         FuncDecl_ decl = c11__getitem(FuncDecl_, &self->func_decls, i);
@@ -139,6 +170,23 @@ void CodeObject__dtor(CodeObject* self) {
     c11_vector__dtor(&self->func_decls);
 }
 
+void CodeObject__build_handlers(CodeObject* self) {
+    c11_vector__clear(&self->handlers);
+    c11__foreach(CodeBlock, &self->blocks, block) {
+        if(block->type != CodeBlockType_TRY) continue;
+        CodeHandler handler = {block->start, block->end, block->depth};
+        c11_vector__push(CodeHandler, &self->handlers, handler);
+    }
+}
+
+InlineCache* CodeObject__init_caches(CodeObject* self) {
+    assert(self->caches == NULL);
+    int size = sizeof(InlineCache) * self->codes.length;
+    self->caches = PK_MALLOC(size);
+    memset(self->caches, 0, size);
+    return self->caches;
+}
+
 void Function__ctor(Function* self, FuncDecl_ decl, py_GlobalRef module, py_Ref globals) {
     PK_INCREF(decl);
     self->decl = decl;
@@ -168,10 +216,17 @@ int CodeObject__add_name(CodeObject* self, py_Name name) {
     return index;
 }
 
+int CodeObject__add_freevar(CodeObject* self, py_Name name) {
+    for(int i = 0; i < self->freevars.length; i++) {
+        if(c11__getitem(py_Name, &self->freevars, i) == name) return i;
+    }
+    c11_vector__push(py_Name, &self->freevars, name);
+    return self->freevars.length - 1;
+}
+
 void Function__dtor(Function* self) {
     // printf("%s() in %s freed!\n", self->decl->code.name->data,
     // self->decl->code.src->filename->data);
     PK_DECREF(self->decl);
-    if(self->closure) NameDict__delete(self->closure);
     memset(self, 0, sizeof(Function));
 }
\ No newline at end of file
@@ -5,8 +5,8 @@
 // Magic number for CodeObject serialization: "CO" = 0x434F
 #define CODEOBJECT_MAGIC 0x434F
 #define CODEOBJECT_VER_MAJOR 1
-#define CODEOBJECT_VER_MINOR 1
-#define CODEOBJECT_VER_MINOR_MIN 1
+#define CODEOBJECT_VER_MINOR 5
+#define CODEOBJECT_VER_MINOR_MIN 5
 
 // Forward declarations
 static void FuncDecl__serialize(c11_serializer* s,
@@ -116,7 +116,10 @@ static void CodeObject__serialize(c11_serializer* s,
     _Static_assert(sizeof(Bytecode) == sizeof(uint16_t) * 2, "");
     c11_serializer__write_i32(s, co->codes.length);
     c11_serializer__write_mark(s, '[');
-    c11_serializer__write_bytes(s, co->codes.data, co->codes.length * sizeof(Bytecode));
+    c11__foreach(Bytecode, &co->codes, bc) {
+        Bytecode tmp = {Bytecode__base_op(bc), bc->arg};
+        c11_serializer__write_bytes(s, &tmp, sizeof(Bytecode));
+    }
     c11_serializer__write_mark(s, ']');
 
     // codes_ex
@@ -153,11 +156,20 @@ static void CodeObject__serialize(c11_serializer* s,
     }
     c11_serializer__write_mark(s, ']');
 
+    // freevars (as cstr via py_name2str)
+    c11_serializer__write_i32(s, co->freevars.length);
+    c11_serializer__write_mark(s, '[');
+    for(int i = 0; i < co->freevars.length; i++) {
+        py_Name name = c11__getitem(py_Name, &co->freevars, i);
+        c11_serializer__write_cstr(s, py_name2str(name));
+    }
+    c11_serializer__write_mark(s, ']');
+
     // nlocals
     c11_serializer__write_i32(s, co->nlocals);
 
     // blocks
-    _Static_assert(sizeof(CodeBlock) == sizeof(int32_t) * 5, "");
+    _Static_assert(sizeof(CodeBlock) == sizeof(int32_t) * 6, "");
     c11_serializer__write_i32(s, co->blocks.length);
     c11_serializer__write_mark(s, '[');
     c11_serializer__write_bytes(s, co->blocks.data, co->blocks.length * sizeof(CodeBlock));
@@ -249,6 +261,15 @@ static CodeObject CodeObject__deserialize(c11_deserializer* d, const char* filen
     }
     c11_deserializer__consume_mark(d, ']');
 
+    // freevars
+    int freevars_len = c11_deserializer__read_i32(d);
+    c11_deserializer__consume_mark(d, '[');
+    for(int i = 0; i < freevars_len; i++) {
+        const char* s = c11_deserializer__read_cstr(d);
+        c11_vector__push(py_Name, &co.freevars, py_name(s));
+    }
+    c11_deserializer__consume_mark(d, ']');
+
     // nlocals
     co.nlocals = c11_deserializer__read_i32(d);
 
@@ -259,6 +280,7 @@ static CodeObject CodeObject__deserialize(c11_deserializer* d, const char* filen
                        c11_deserializer__read_bytes(d, blocks_len * sizeof(CodeBlock)),
                        blocks_len);
     c11_deserializer__consume_mark(d, ']');
+    CodeObject__build_handlers(&co);
 
     // func_decls
     int func_decls_len = c11_deserializer__read_i32(d);
@@ -310,6 +332,15 @@ static void FuncDecl__serialize(c11_serializer* s,
     // nested
     c11_serializer__write_i8(s, decl->nested ? 1 : 0);
 
+    // captures
+    _Static_assert(sizeof(FuncDeclCapture) == sizeof(int32_t) * 2, "");
+    c11_serializer__write_i32(s, decl->captures.length);
+    c11_serializer__write_mark(s, '[');
+    c11_serializer__write_bytes(s,
+                                decl->captures.data,
+                                decl->captures.length * sizeof(FuncDeclCapture));
+    c11_serializer__write_mark(s, ']');
+
     // docstring
     int has_docstring = decl->docstring != NULL ? 1 : 0;
     c11_serializer__write_i8(s, has_docstring);
@@ -327,6 +358,7 @@ static FuncDecl_ FuncDecl__deserialize(c11_deserializer* d, SourceData_ embedded
 
     c11_vector__ctor(&self->args, sizeof(int32_t));
     c11_vector__ctor(&self->kwargs, sizeof(FuncDeclKwArg));
+    c11_vector__ctor(&self->captures, sizeof(FuncDeclCapture));
     c11_smallmap_n2d__ctor(&self->kw_to_index);
 
     // CodeObject (embedded)
@@ -363,6 +395,14 @@ static FuncDecl_ FuncDecl__deserialize(c11_deserializer* d, SourceData_ embedded
     // nested
     self->nested = c11_deserializer__read_i8(d) != 0;
 
+    // captures
+    int captures_len = c11_deserializer__read_i32(d);
+    c11_deserializer__consume_mark(d, '[');
+    c11_vector__extend(&self->captures,
+                       c11_deserializer__read_bytes(d, captures_len * sizeof(FuncDeclCapture)),
+                       captures_len);
+    c11_deserializer__consume_mark(d, ']');
+
     // docstring
     int has_docstring = c11_deserializer__read_i8(d);
     if(has_docstring) {
@@ -67,6 +67,70 @@ static void NameDict__rehash_2x(NameDict* self) {
     PK_FREE(old_items);
 }
 
+/* InstanceShape */
+InstanceShape* InstanceShape__new_root() {
+    InstanceShape* self = PK_MALLOC(sizeof(InstanceShape));
+    self->parent = NULL;
+    self->length = 0;
+    self->max_length = 0;
+    self->count = 1;
+    self->keys = NULL;
+    c11_vector__ctor(&self->children, sizeof(InstanceShape*));
+    return self;
+}
+
+void InstanceShape__delete(InstanceShape* self) {
+    c11__foreach(InstanceShape*, &self->children, child) InstanceShape__delete(*child);
+    c11_vector__dtor(&self->children);
+    PK_FREE(self->keys);
+    PK_FREE(self);
+}
+
+int InstanceShape__index(const InstanceShape* self, py_Name key) {
+    for(int i = 0; i < self->length; i++) {
+        if(self->keys[i] == key) return i;
+    }
+    return -1;
+}
+
+// the shape with `key` appended, NULL if the limits are reached
+static InstanceShape* InstanceShape__add(InstanceShape* self, py_Name key) {
+    c11__foreach(InstanceShape*, &self->children, child) {
+        if((*child)->keys[self->length] == key) return *child;
+    }
+    if(self->length >= PK_INST_SHAPE_MAX_KEYS) return NULL;
+    InstanceShape* root = self;
+    while(root->parent) root = root->parent;
+    if(root->count >= PK_INST_SHAPE_MAX_COUNT) return NULL;
+    root->count++;
+
+    InstanceShape* child = PK_MALLOC(sizeof(InstanceShape));
+    child->parent = self;
+    child->length = self->length + 1;
+    child->max_length = child->length;
+    child->count = 0;
+    child->keys = PK_MALLOC(sizeof(py_Name) * child->length);
+    if(self->length) memcpy(child->keys, self->keys, sizeof(py_Name) * self->length);
+    child->keys[self->length] = key;
+    c11_vector__ctor(&child->children, sizeof(InstanceShape*));
+    c11_vector__push(InstanceShape*, &self->children, child);
+    for(InstanceShape* p = self; p && p->max_length < child->length; p = p->parent) {
+        p->max_length = child->length;
+    }
+    return child;
+}
+
+// convert a shaped dict into a hash table
+static void NameDict__unshape(NameDict* self) {
+    InstanceShape* shape = self->shape;
+    py_TValue* values = self->values;
+    NameDict__ctor(self, self->load_factor);
+    for(int i = 0; i < shape->length; i++) {
+        NameDict__set(self, shape->keys[i], &values[i]);
+    }
+    PK_FREE(values);
+}
+
 NameDict* NameDict__new(float load_factor) {
     NameDict* p = PK_MALLOC(sizeof(NameDict));
     NameDict__ctor(p, load_factor);
@@ -85,9 +149,28 @@ void NameDict__ctor(NameDict* self, float load_factor) {
     NameDict__set_capacity_and_alloc_items(self, 4);
 }
 
-void NameDict__dtor(NameDict* self) { PK_FREE(self->items); }
+void NameDict__ctor_shaped(NameDict* self, InstanceShape* root) {
+    self->length = 0;
+    self->load_factor = PK_INST_ATTR_LOAD_FACTOR;
+    self->capacity = 0;
+    self->critical_size = -1;
+    self->shape = root;
+    self->values = NULL;
+}
+
+void NameDict__dtor(NameDict* self) {
+    if(NameDict__is_shaped(self)) {
+        PK_FREE(self->values);
+    } else {
+        PK_FREE(self->items);
+    }
+}
 
 py_TValue* NameDict__try_get(NameDict* self, py_Name key) {
+    if(NameDict__is_shaped(self)) {
+        int index = InstanceShape__index(self->shape, key);
+        return index >= 0 ? &self->values[index] : NULL;
+    }
     bool ok;
     uintptr_t i;
     HASH_PROBE_0(key, ok, i);
@@ -96,6 +179,7 @@ py_TValue* NameDict__try_get(NameDict* self, py_Name key) {
 }
 
 bool NameDict__contains(NameDict* self, py_Name key) {
+    if(NameDict__is_shaped(self)) return InstanceShape__index(self->shape, key) >= 0;
     bool ok;
     uintptr_t i;
     HASH_PROBE_0(key, ok, i);
@@ -103,6 +187,28 @@ bool NameDict__contains(NameDict* self, py_Name key) {
 }
 
 void NameDict__set(NameDict* self, py_Name key, py_TValue* val) {
+    if(NameDict__is_shaped(self)) {
+        int index = InstanceShape__index(self->shape, key);
+        if(index >= 0) {
+            self->values[index] = *val;
+            return;
+        }
+        InstanceShape* child = InstanceShape__add(self->shape, key);
+        if(child == NULL) {
+            NameDict__unshape(self);
+            NameDict__set(self, key, val);
+            return;
+        }
+        if(self->length == self->capacity) {
+            // instances of the same class usually end up with the same number of keys
+            int capacity = c11__max(child->max_length, self->capacity * 2);
+            self->values = PK_REALLOC(self->values, sizeof(py_TValue) * capacity);
+            self->capacity = capacity;
+        }
+        self->values[self->length++] = *val;
+        self->shape = child;
+        return;
+    }
     bool ok;
     uintptr_t i;
     HASH_PROBE_1(key, ok, i);
@@ -118,6 +224,10 @@ void NameDict__set(NameDict* self, py_Name key, py_TValue* val) {
 }
 
 bool NameDict__del(NameDict* self, py_Name key) {
+    if(NameDict__is_shaped(self)) {
+        if(InstanceShape__index(self->shape, key) < 0) return false;
+        NameDict__unshape(self);
+    }
     bool ok;
     uintptr_t i;
     HASH_PROBE_0(key, ok, i);
@@ -149,6 +259,11 @@ bool NameDict__del(NameDict* self, py_Name key) {
 }
 
 void NameDict__clear(NameDict* self) {
+    if(NameDict__is_shaped(self)) {
+        while(self->shape->parent) self->shape = self->shape->parent;
+        self->length = 0;
+        return;
+    }
     for(int i = 0; i < self->capacity; i++) {
         self->items[i].key = NULL;
         self->items[i].value = *py_NIL();
@@ -156,6 +271,18 @@ void NameDict__clear(NameDict* self) {
     self->length = 0;
 }
 
+int NameDict__end(NameDict* self) {
+    return NameDict__is_shaped(self) ? self->length : self->capacity;
+}
+
+py_Name NameDict__key_at(NameDict* self, int i) {
+    return NameDict__is_shaped(self) ? self->shape->keys[i] : self->items[i].key;
+}
+
+py_TValue* NameDict__value_at(NameDict* self, int i) {
+    return NameDict__is_shaped(self) ? &self->values[i] : &self->items[i].value;
+}
+
 #undef HASH_PROBE_0
 #undef HASH_PROBE_1
 #undef HASH_KEY
\ No newline at end of file
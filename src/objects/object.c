@@ -3,15 +3,18 @@
 #include <assert.h>
 
 PK_INLINE void* PyObject__userdata(PyObject* self) {
-    return self->flex + PK_OBJ_SLOTS_SIZE(self->slots);
+    PyObject__write_barrier(self);
+    return PyObject__userdata_raw(self);
 }
 
 PK_INLINE NameDict* PyObject__dict(PyObject* self) {
     assert(self->slots == -1);
-    return (NameDict*)(self->flex);
+    PyObject__write_barrier(self);
+    return PyObject__dict_raw(self);
 }
 
 PK_INLINE py_TValue* PyObject__slots(PyObject* self) {
     assert(self->slots >= 0);
-    return (py_TValue*)(self->flex);
-}
\ No newline at end of file
+    PyObject__write_barrier(self);
+    return PyObject__slots_raw(self);
+}
@@ -6,19 +6,40 @@ PK_INLINE void py_setreg(int i, py_Ref val) { pk_current_vm->reg[i] = *val; }
 
 PK_INLINE py_Ref py_retval() { return &pk_current_vm->last_retval; }
 
+// invalidate inline caches that depend on the `__dict__` of types and modules
+static void pk__dict_modified(py_Ref self) {
+    if(self->type == tp_type) {
+        py_TypeInfo__modified(PyObject__userdata_raw(self->_obj));
+    } else if(self->type == tp_module) {
+        py_ModuleInfo__modified(PyObject__userdata_raw(self->_obj));
+    }
+}
+
 PK_INLINE py_Ref py_getdict(py_Ref self, py_Name name) {
     assert(self && self->is_ptr);
-    return NameDict__try_get(PyObject__dict(self->_obj), name);
+    return NameDict__try_get(PyObject__dict_raw(self->_obj), name);
 }
 
 PK_INLINE void py_setdict(py_Ref self, py_Name name, py_Ref val) {
     assert(self && self->is_ptr);
-    NameDict__set(PyObject__dict(self->_obj), name, val);
+    NameDict* dict = PyObject__dict(self->_obj);
+    if(self->type == tp_module) {
+        // global caches hold the slots of a module, overwriting one keeps them valid
+        py_Ref slot = NameDict__try_get(dict, name);
+        if(slot) {
+            *slot = *val;
+            return;
+        }
+    }
+    pk__dict_modified(self);
+    NameDict__set(dict, name, val);
 }
 
 bool py_deldict(py_Ref self, py_Name name) {
     assert(self && self->is_ptr);
-    return NameDict__del(PyObject__dict(self->_obj), name);
+    bool ok = NameDict__del(PyObject__dict(self->_obj), name);
+    if(ok) pk__dict_modified(self);
+    return ok;
 }
 
 py_ItemRef py_emplacedict(py_Ref self, py_Name name) {
@@ -29,10 +50,10 @@ py_ItemRef py_emplacedict(py_Ref self, py_Name name) {
 bool py_applydict(py_Ref self, bool (*f)(py_Name, py_Ref, void*), void* ctx) {
     assert(self && self->is_ptr);
     NameDict* dict = PyObject__dict(self->_obj);
-    for(int i = 0; i < dict->capacity; i++) {
-        NameDict_KV* kv = &dict->items[i];
-        if(kv->key == NULL) continue;
-        bool ok = f(kv->key, &kv->value, ctx);
+    for(int i = 0; i < NameDict__end(dict); i++) {
+        py_Name key = NameDict__key_at(dict, i);
+        if(key == NULL) continue;
+        bool ok = f(key, NameDict__value_at(dict, i), ctx);
         if(!ok) return false;
     }
     return true;
@@ -40,6 +61,7 @@ bool py_applydict(py_Ref self, bool (*f)(py_Name, py_Ref, void*), void* ctx) {
 
 void py_cleardict(py_Ref self) {
     assert(self && self->is_ptr);
+    pk__dict_modified(self);
     NameDict* dict = PyObject__dict(self->_obj);
     NameDict__clear(dict);
 }
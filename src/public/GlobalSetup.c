@@ -129,6 +129,7 @@ void py_sys_setargv(int argc, char** argv) {
 void py_sys_settrace(py_TraceFunc func, bool reset) {
     TraceInfo* info = &pk_current_vm->trace_info;
     info->func = func;
+    VM__update_instrumentation(pk_current_vm);
     if(!reset) return;
     if(info->prev_loc.src) {
         PK_DECREF(info->prev_loc.src);
@@ -142,6 +143,16 @@ int py_gc_collect() {
     return ManagedHeap__collect(heap);
 }
 
+bool py_gc_step(int budget_us) {
+    ManagedHeap* heap = &pk_current_vm->heap;
+    return ManagedHeap__step(heap, budget_us);
+}
+
+void py_gc_setthreads(int n) {
+    ManagedHeap* heap = &pk_current_vm->heap;
+    ManagedHeap__set_threads(heap, n);
+}
+
 /////////////////////////////
 
 void* py_malloc(size_t size) { return PK_MALLOC(size); }
@@ -13,6 +13,13 @@ py_Ref py_getmodule(const char* path) {
     return BinTree__try_get(&vm->modules, (void*)path);
 }
 
+void py_ModuleInfo__modified(py_ModuleInfo* self) {
+    VM* vm = pk_current_vm;
+    // 0 marks empty global caches, skip it when the counter wraps around
+    if(++vm->next_module_version == 0) vm->next_module_version = 1;
+    self->version = vm->next_module_version;
+}
+
 static py_Ref pk_newmodule(const char* path, bool is_init) {
     c11_sv pathv = {path, strlen(path)};
     if(pathv.size > PK_MAX_MODULE_PATH_LEN) c11__abort("module path too long: %s", path);
@@ -30,6 +37,7 @@ static py_Ref pk_newmodule(const char* path, bool is_init) {
 
     mi->path = c11_string__new(path);
     path = mi->path->data;
+    py_ModuleInfo__modified(mi);
 
     // we do not allow override in order to avoid memory leak
     // it is because Module objects are not garbage collected
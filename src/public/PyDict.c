@@ -389,7 +389,7 @@ static bool dict__init__(int argc, py_Ref argv) {
 
 static bool dict__getitem__(int argc, py_Ref argv) {
     PY_CHECK_ARGC(2);
-    Dict* self = py_touserdata(argv);
+    Dict* self = PyObject__userdata_raw(argv->_obj);
     DictEntry* entry;
     if(!Dict__try_get(self, py_arg(1), &entry)) return false;
     if(entry) {
@@ -424,7 +424,7 @@ static bool dict__delitem__(int argc, py_Ref argv) {
 
 static bool dict__contains__(int argc, py_Ref argv) {
     PY_CHECK_ARGC(2);
-    Dict* self = py_touserdata(argv);
+    Dict* self = PyObject__userdata_raw(argv->_obj);
     DictEntry* entry;
     if(!Dict__try_get(self, py_arg(1), &entry)) return false;
     py_newbool(py_retval(), entry != NULL);
@@ -433,7 +433,7 @@ static bool dict__contains__(int argc, py_Ref argv) {
 
 static bool dict__len__(int argc, py_Ref argv) {
     PY_CHECK_ARGC(1);
-    Dict* self = py_touserdata(argv);
+    Dict* self = PyObject__userdata_raw(argv->_obj);
     py_newint(py_retval(), self->length);
     return true;
 }
@@ -550,7 +550,7 @@ static bool dict_update(int argc, py_Ref argv) {
 }
 
 static bool dict_get(int argc, py_Ref argv) {
-    Dict* self = py_touserdata(argv);
+    Dict* self = PyObject__userdata_raw(argv->_obj);
     if(argc > 3) return TypeError("get() takes at most 3 arguments (%d given)", argc);
     py_Ref default_val = argc == 3 ? py_arg(2) : py_None();
     DictEntry* entry;
@@ -589,7 +589,7 @@ static bool dict_popitem(int argc, py_Ref argv) {
 
 static bool dict_keys(int argc, py_Ref argv) {
     PY_CHECK_ARGC(1);
-    Dict* self = py_touserdata(argv);
+    Dict* self = PyObject__userdata_raw(argv->_obj);
     DictIterator* ud = py_newobject(py_retval(), tp_dict_iterator, 1, sizeof(DictIterator));
     DictIterator__ctor(ud, self, 0);
     py_setslot(py_retval(), 0, argv);  // keep a reference to the dict
@@ -598,7 +598,7 @@ static bool dict_keys(int argc, py_Ref argv) {
 
 static bool dict_values(int argc, py_Ref argv) {
     PY_CHECK_ARGC(1);
-    Dict* self = py_touserdata(argv);
+    Dict* self = PyObject__userdata_raw(argv->_obj);
     DictIterator* ud = py_newobject(py_retval(), tp_dict_iterator, 1, sizeof(DictIterator));
     DictIterator__ctor(ud, self, 1);
     py_setslot(py_retval(), 0, argv);  // keep a reference to the dict
@@ -607,7 +607,7 @@ static bool dict_values(int argc, py_Ref argv) {
 
 static bool dict_items(int argc, py_Ref argv) {
     PY_CHECK_ARGC(1);
-    Dict* self = py_touserdata(argv);
+    Dict* self = PyObject__userdata_raw(argv->_obj);
     DictIterator* ud = py_newobject(py_retval(), tp_dict_iterator, 1, sizeof(DictIterator));
     DictIterator__ctor(ud, self, 2);
     py_setslot(py_retval(), 0, argv);  // keep a reference to the dict
@@ -689,7 +689,7 @@ py_Type pk_dict_items__register() {
 
 int py_dict_getitem(py_Ref self, py_Ref key) {
     assert(py_isdict(self));
-    Dict* ud = py_touserdata(self);
+    Dict* ud = PyObject__userdata_raw(self->_obj);
     DictEntry* entry;
     if(!Dict__try_get(ud, key, &entry)) return -1;
     if(entry) {
@@ -755,7 +755,7 @@ int py_dict_delitem_by_int(py_Ref self, py_i64 key) {
 
 int py_dict_len(py_Ref self) {
     assert(py_isdict(self));
-    Dict* ud = py_touserdata(self);
+    Dict* ud = PyObject__userdata_raw(self->_obj);
     return ud->length;
 }
 
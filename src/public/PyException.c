@@ -6,46 +6,88 @@
 #include "pocketpy/common/sstream.h"
 #include "pocketpy/objects/exception.h"
 
-void py_BaseException__stpush(py_Frame* frame,
-                              py_Ref self,
-                              SourceData_ src,
-                              int lineno,
-                              const char* func_name) {
+void py_BaseException__stpush(py_Frame* frame, py_Ref self, SourceData_ src, int lineno) {
     BaseException* ud = py_touserdata(self);
     int max_frame_dumps = py_debugger_status() == 1 ? 31 : 7;
     if(ud->stacktrace.length >= max_frame_dumps) return;
     BaseExceptionFrame* frame_dump = c11_vector__emplace(&ud->stacktrace);
-    PK_INCREF(src);
-    frame_dump->src = src;
-    frame_dump->lineno = lineno;
-    frame_dump->name = func_name ? c11_string__new(func_name) : NULL;
+    if(frame != NULL && !frame->is_locals_special) {
+        // a function frame, its code object lives in the `FuncDecl`
+        FuncDecl* decl = (FuncDecl*)((char*)frame->co - offsetof(FuncDecl, code));
+        PK_INCREF(decl);
+        frame_dump->decl = decl;
+        frame_dump->src = NULL;
+        frame_dump->pos = frame->ip;
+    } else {
+        // module-level code may be gone before the traceback is formatted
+        if(frame != NULL) {
+            src = frame->co->src;
+            lineno = Frame__lineno(frame);
+        }
+        PK_INCREF(src);
+        frame_dump->decl = NULL;
+        frame_dump->src = src;
+        frame_dump->pos = lineno;
+    }
 
     if(py_debugger_status() == 1) {
+        py_TValue* locals = c11_vector__emplace(&ud->snapshots);
+        py_TValue* globals = c11_vector__emplace(&ud->snapshots);
         if(frame != NULL) {
-            py_Frame_newlocals(frame, &frame_dump->locals);
-            py_Frame_newglobals(frame, &frame_dump->globals);
+            py_Frame_newlocals(frame, locals);
+            py_Frame_newglobals(frame, globals);
         } else {
-            py_newdict(&frame_dump->locals);
-            py_newdict(&frame_dump->globals);
+            py_newdict(locals);
+            py_newdict(globals);
         }
     }
 }
 
+SourceData_ BaseExceptionFrame__src(const BaseExceptionFrame* self) {
+    return self->decl ? self->decl->code.src : self->src;
+}
+
+int BaseExceptionFrame__lineno(const BaseExceptionFrame* self) {
+    if(self->decl == NULL) return self->pos;
+    const CodeObject* co = &self->decl->code;
+    if(self->pos < 0) return co->start_line;
+    return c11__at(BytecodeEx, &co->codes_ex, self->pos)->lineno;
+}
+
+const char* BaseExceptionFrame__name(const BaseExceptionFrame* self) {
+    return self->decl ? self->decl->code.name->data : NULL;
+}
+
 static void BaseException__dtor(void* ud) {
     BaseException* self = (BaseException*)ud;
     c11__foreach(BaseExceptionFrame, &self->stacktrace, it) {
-        PK_DECREF(it->src);
-        if(it->name) c11_string__delete(it->name);
+        if(it->decl) {
+            PK_DECREF(it->decl);
+        } else {
+            PK_DECREF(it->src);
+        }
     }
     c11_vector__dtor(&self->stacktrace);
+    c11_vector__dtor(&self->snapshots);
 }
 
-static bool _py_BaseException__new__(int argc, py_Ref argv) {
-    py_Type cls = py_totype(argv);
-    BaseException* ud = py_newobject(py_retval(), cls, 0, sizeof(BaseException));
+static BaseException* BaseException__new(py_OutRef out, py_Type cls) {
+    BaseException* ud = py_newobject(out, cls, 0, sizeof(BaseException));
     py_newnil(&ud->args);
     py_newnil(&ud->inner_exc);
     c11_vector__ctor(&ud->stacktrace, sizeof(BaseExceptionFrame));
+    c11_vector__ctor(&ud->snapshots, sizeof(py_TValue));
+    return ud;
+}
+
+void py_BaseException__materialize(py_Ref self) {
+    if(self->is_ptr) return;
+    assert(self->type == tp_StopIteration);
+    BaseException__new(self, tp_StopIteration);
+}
+
+static bool _py_BaseException__new__(int argc, py_Ref argv) {
+    BaseException__new(py_retval(), py_totype(argv));
     return true;
 }
 
@@ -148,11 +190,11 @@ static void c11_sbuf__write_exc(c11_sbuf* self, py_Ref exc) {
 
     for(int i = ud->stacktrace.length - 1; i >= 0; i--) {
         BaseExceptionFrame* frame = c11__at(BaseExceptionFrame, &ud->stacktrace, i);
-        SourceData__snapshot(frame->src,
+        SourceData__snapshot(BaseExceptionFrame__src(frame),
                              self,
-                             frame->lineno,
+                             BaseExceptionFrame__lineno(frame),
                              NULL,
-                             frame->name ? frame->name->data : NULL);
+                             BaseExceptionFrame__name(frame));
         c11_sbuf__write_char(self, '\n');
     }
 
@@ -200,7 +242,10 @@ bool py_matchexc(py_Type type) {
     VM* vm = pk_current_vm;
     if(py_isnil(&vm->unhandled_exc)) return false;
     bool ok = py_issubclass(vm->unhandled_exc.type, type);
-    if(ok) vm->last_retval = vm->unhandled_exc;
+    if(ok) {
+        py_BaseException__materialize(&vm->unhandled_exc);
+        vm->last_retval = vm->unhandled_exc;
+    }
     return ok;
 }
 
@@ -224,6 +269,7 @@ void py_printexc() {
 char* py_formatexc() {
     VM* vm = pk_current_vm;
     if(py_isnil(&vm->unhandled_exc)) return NULL;
+    py_BaseException__materialize(&vm->unhandled_exc);
     char* res = formatexc_internal(&vm->unhandled_exc);
     if(py_debugger_status() == 1) py_debugger_exceptionbreakpoint(&vm->unhandled_exc);
     return res;
@@ -285,10 +331,10 @@ bool py_raise(py_Ref exc) {
     assert(py_isinstance(exc, tp_BaseException));
     VM* vm = pk_current_vm;
     if(vm->top_frame) {
-        FrameExcInfo* info = Frame__top_exc_info(vm->top_frame);
-        if(info && !py_isnil(&info->exc)) {
+        py_Ref handled = Frame__handled_exc(vm->top_frame);
+        if(handled && exc->is_ptr) {
             BaseException* ud = py_touserdata(exc);
-            ud->inner_exc = info->exc;
+            ud->inner_exc = *handled;
         }
     }
     assert(py_isnil(&vm->unhandled_exc));
@@ -303,7 +349,10 @@ bool KeyError(py_Ref key) {
 }
 
 bool StopIteration() {
-    bool ok = py_tpcall(tp_StopIteration, 0, NULL);
-    if(!ok) return false;
-    return py_raise(py_retval());
+    // exhausted iterators are common, allocate the exception object only if it is caught
+    VM* vm = pk_current_vm;
+    assert(py_isnil(&vm->unhandled_exc));
+    vm->unhandled_exc.type = tp_StopIteration;
+    vm->unhandled_exc.is_ptr = false;
+    return false;
 }
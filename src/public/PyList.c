@@ -39,7 +39,7 @@ void py_list_delitem(py_Ref self, int i) {
 }
 
 int py_list_len(py_Ref self) {
-    List* ud = py_touserdata(self);
+    List* ud = PyObject__userdata_raw(self->_obj);
     return ud->length;
 }
 
@@ -132,7 +132,7 @@ static bool list__new__(int argc, py_Ref argv) {
 
 static bool list__getitem__(int argc, py_Ref argv) {
     PY_CHECK_ARGC(2);
-    List* self = py_touserdata(py_arg(0));
+    List* self = PyObject__userdata_raw(py_arg(0)->_obj);
     py_Ref _1 = py_arg(1);
     if(_1->type == tp_int) {
         int index = py_toint(py_arg(1));
@@ -433,7 +433,7 @@ static bool list_sort(int argc, py_Ref argv) {
 static bool list__iter__(int argc, py_Ref argv) {
     PY_CHECK_ARGC(1);
     list_iterator* ud = py_newobject(py_retval(), tp_list_iterator, 1, sizeof(list_iterator));
-    ud->vec = py_touserdata(argv);
+    ud->vec = PyObject__userdata_raw(argv->_obj);  // only read by the iterator
     ud->index = 0;
     py_setslot(py_retval(), 0, argv);  // keep a reference to the object
     return true;
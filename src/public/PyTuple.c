@@ -78,7 +78,7 @@ static bool tuple__getitem__(int argc, py_Ref argv) {
     if(_1->type == tp_int) {
         int index = py_toint(py_arg(1));
         if(!pk__normalize_index(&index, length)) return false;
-        *py_retval() = *py_getslot(argv, index);
+        *py_retval() = PyObject__slots_raw(argv->_obj)[index];
         return true;
     } else if(_1->type == tp_slice) {
         int start, stop, step;
@@ -146,7 +146,7 @@ static bool tuple__lt__(int argc, py_Ref argv) {
 static bool tuple__iter__(int argc, py_Ref argv) {
     PY_CHECK_ARGC(1);
     tuple_iterator* ud = py_newobject(py_retval(), tp_tuple_iterator, 1, sizeof(tuple_iterator));
-    ud->p = py_tuple_data(argv);
+    ud->p = PyObject__slots_raw(argv->_obj);  // only read by the iterator
     ud->length = py_tuple_len(argv);
     ud->index = 0;
     py_setslot(py_retval(), 0, argv);  // keep a reference to the object
@@ -144,9 +144,14 @@ bool py_iter(py_Ref val) {
 int py_next(py_Ref val) {
     VM* vm = pk_current_vm;
 
+    bool ok;
+    int prev_next_depth = vm->next_depth;
     switch(val->type) {
         case tp_generator:
-            if(generator__next__(1, val)) return 1;
+            vm->next_depth = vm->recursion_depth;
+            ok = VM__callcfunc(vm, generator__next__, 1, val);
+            vm->next_depth = prev_next_depth;
+            if(ok) return 1;
             break;
         case tp_array2d_like_iterator:
             if(array2d_like_iterator__next__(1, val)) return 1;
@@ -172,7 +177,10 @@ int py_next(py_Ref val) {
                 TypeError("'%t' object is not an iterator", val->type);
                 return -1;
             }
-            if(py_call(tmp, 1, val)) return 1;
+            vm->next_depth = vm->recursion_depth;
+            ok = py_call(tmp, 1, val);
+            vm->next_depth = prev_next_depth;
+            if(ok) return 1;
             break;
         }
     }
@@ -198,6 +206,15 @@ bool py_repr(py_Ref val) { return pk_callmagic(__repr__, 1, val); }
 
 bool py_len(py_Ref val) { return pk_callmagic(__len__, 1, val); }
 
+// the instance slot of a `__slots__` member, NULL if `self` does not have it
+static py_Ref member_slot(py_Ref self, py_Ref descr) {
+    if(self->is_ptr && descr->extra < self->_obj->slots) {
+        return PyObject__slots(self->_obj) + descr->extra;
+    }
+    TypeError("member '%n' does not apply to '%t' object", (py_Name)descr->_ptr, self->type);
+    return NULL;
+}
+
 bool py_getattr(py_Ref self, py_Name name) {
     // https://docs.python.org/3/howto/descriptor.html#invocation-from-an-instance
     py_TypeInfo* ti = pk_typeinfo(self->type);
@@ -210,6 +227,13 @@ bool py_getattr(py_Ref self, py_Name name) {
             py_Ref getter = py_getslot(cls_var, 0);
             return py_call(getter, 1, self);
         }
+        if(py_istype(cls_var, tp_member_descriptor)) {
+            py_Ref slot = member_slot(self, cls_var);
+            if(!slot) return false;
+            if(py_isnil(slot)) return AttributeError(self, name);
+            py_assign(py_retval(), slot);
+            return true;
+        }
     }
     // handle instance __dict__
     if(self->is_ptr && self->_obj->slots == -1) {
@@ -310,6 +334,12 @@ bool py_setattr(py_Ref self, py_Name name, py_Ref val) {
                 return TypeError("readonly attribute: '%n'", name);
             }
         }
+        if(py_istype(cls_var, tp_member_descriptor)) {
+            py_Ref slot = member_slot(self, cls_var);
+            if(!slot) return false;
+            *slot = *val;
+            return true;
+        }
     }
 
     // handle instance __dict__
@@ -318,6 +348,8 @@ bool py_setattr(py_Ref self, py_Name name, py_Ref val) {
         return true;
     }
 
+    // instances of a class with `__slots__`
+    if(ti->is_python) return AttributeError(self, name);
     return TypeError("cannot set attribute");
 }
 
@@ -325,6 +357,15 @@ bool py_delattr(py_Ref self, py_Name name) {
     py_TypeInfo* ti = pk_typeinfo(self->type);
     if(ti->delattribute) return ti->delattribute(self, name);
 
+    py_Ref cls_var = pk_tpfindname(ti, name);
+    if(cls_var && py_istype(cls_var, tp_member_descriptor)) {
+        py_Ref slot = member_slot(self, cls_var);
+        if(!slot) return false;
+        if(py_isnil(slot)) return AttributeError(self, name);
+        py_newnil(slot);
+        return true;
+    }
+
     if(self->is_ptr && self->_obj->slots == -1) {
         if(py_deldict(self, name)) return true;
         return AttributeError(self, name);
@@ -60,7 +60,7 @@ PK_INLINE bool py_vectorcall(uint16_t argc, uint16_t kwargc) {
 
 bool py_call(py_Ref f, int argc, py_Ref argv) {
     if(f->type == tp_nativefunc) {
-        return py_callcfunc(f->_cfunc, argc, argv);
+        return VM__callcfunc(pk_current_vm, f->_cfunc, argc, argv);
     } else {
         py_push(f);
         py_pushnil();
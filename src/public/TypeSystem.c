@@ -101,4 +101,5 @@ void py_tphookattributes(py_Type type,
     ti->setattribute = setattribute;
     ti->delattribute = delattribute;
     ti->getunboundmethod = getunboundmethod;
+    py_TypeInfo__modified(ti);
 }
@@ -871,4 +871,33 @@ assert 9 // 7 == 1
 assert 9 % 8 == 1
 assert 9 // 8 == 1
 assert 9 % 9 == 0
-assert 9 // 9 == 1
\ No newline at end of file
+assert 9 // 9 == 1
+# mixed int/float operands
+a, b = 7, 2.0
+assert a + b == 9.0 and type(a + b) is float
+assert b - a == -5.0 and type(b - a) is float
+assert a * b == 14.0
+assert a / 2 == 3.5
+assert a // b == 3.0 and type(a // b) is float
+assert a % b == 1.0 and type(a % b) is float
+assert -a % b == 1.0
+assert a ** 2 == 49 and type(a ** 2) is int
+assert a ** -1 == 1 / 7
+assert a ** b == 49.0
+assert (a < b, a <= b, a == b, a != b, a > b, a >= b) == (False, False, False, True, True, True)
+assert 2 == 2.0 and not (2 != 2.0)
+assert -a == -7 and ~a == -8 and -b == -2.0
+
+for x, y in [(1, 0), (1, 0.0), (1.0, 0), (1.0, 0.0)]:
+    for op in ['/', '//', '%']:
+        try:
+            eval(f'x {op} y', {'x': x, 'y': y})
+            exit(1)
+        except ZeroDivisionError:
+            pass
+
+try:
+    0 ** -1
+    exit(1)
+except ZeroDivisionError:
+    pass
@@ -0,0 +1,79 @@
+x = 1
+
+def get_x():
+    return x
+
+def get_len():
+    return len
+
+def set_x(val):
+    global x
+    x = val
+
+def del_x():
+    global x
+    del x
+
+for _ in range(3):
+    assert get_x() == 1
+
+# STORE_GLOBAL
+set_x(2)
+assert get_x() == 2
+x = 3
+assert get_x() == 3
+
+# DELETE_GLOBAL
+del_x()
+try:
+    get_x()
+    exit(1)
+except NameError:
+    pass
+x = 4
+assert get_x() == 4
+
+# setattr on the module
+import __main__
+setattr(__main__, 'x', 5)
+assert get_x() == 5
+x = 4
+
+# globals shadowing builtins
+builtin_len = len
+for _ in range(3):
+    assert get_len() is builtin_len
+len = lambda obj: 0
+assert get_len() is not builtin_len
+assert get_len()([1, 2]) == 0
+del len
+assert get_len() is builtin_len
+
+# module-level names
+for i in range(3):
+    assert x == 4
+    assert abs(-i) == i
+
+# modifying builtins
+import builtins
+for _ in range(3):
+    assert get_len() is builtin_len
+builtins.len = lambda obj: -1
+assert get_len()([1]) == -1
+builtins.len = builtin_len
+assert get_len() is builtin_len
+
+# the same code object with different globals
+code = compile('y + 1', '<eval>', 'eval')
+for i in range(3):
+    assert eval(code, {'y': i}) == i + 1
+
+# adding globals may move the slots of the cached ones
+for _ in range(3):
+    assert get_x() == 4
+for i in range(100):
+    setattr(__main__, 'g' + str(i), i)
+assert get_x() == 4
+x = 6
+assert get_x() == 6
+assert g99 == 99
@@ -0,0 +1,126 @@
+# the stack is unwound to the depth of the try statement
+def parse_all(items):
+    res = []
+    for s in items:
+        try:
+            res.append(int(s) + [1, 2, int(s)][2])
+        except ValueError:
+            res.append(None)
+    return res
+
+assert parse_all(['1', 'x', '3']) == [2, None, 6]
+
+d = {'a': 1}
+n = 0
+for i in range(100):
+    try:
+        n += d['b' if i % 2 else 'a']
+    except KeyError:
+        n -= 1
+assert n == 0
+
+class Ctx:
+    def __enter__(self):
+        return self
+    def __exit__(self, *args):
+        pass
+
+def in_with_and_match(x):
+    with Ctx():
+        match x:
+            case 1:
+                try:
+                    return [0, 1 // (x - 1)]
+                except ZeroDivisionError:
+                    return 'zero'
+            case _:
+                return 'other'
+
+assert in_with_and_match(1) == 'zero'
+assert in_with_and_match(2) == 'other'
+
+class InClassBody:
+    try:
+        value = {}['missing']
+    except KeyError:
+        value = 'default'
+
+assert InClassBody.value == 'default'
+
+# nested try blocks and except clauses
+def nested(a, b):
+    try:
+        try:
+            return a // b
+        except ZeroDivisionError:
+            try:
+                [][a]
+            except IndexError as e:
+                return type(e).__name__
+    except TypeError:
+        return 'type'
+
+assert nested(4, 2) == 2
+assert nested(1, 0) == 'IndexError'
+assert nested('x', 'y') == 'type'
+
+# break and continue leave except clauses
+res = []
+for i in range(5):
+    try:
+        raise ValueError(i)
+    except ValueError as e:
+        if i == 1:
+            continue
+        if i == 3:
+            break
+        res.append(e.args[0])
+assert res == [0, 2]
+
+# bare raise inside an except clause
+def reraise():
+    try:
+        raise KeyError('k')
+    except KeyError:
+        for _ in range(2):
+            pass
+        raise
+
+try:
+    reraise()
+    exit(1)
+except KeyError as e:
+    assert e.args[0] == 'k'
+
+# raising in the except clause goes to the outer handler
+def raise_in_handler():
+    try:
+        try:
+            raise KeyError
+        except KeyError:
+            raise IndexError
+    except IndexError:
+        return True
+
+assert raise_in_handler()
+
+# try blocks across yields
+def gen():
+    for i in range(3):
+        try:
+            yield i
+            raise ValueError(i)
+        except ValueError as e:
+            yield -e.args[0]
+
+assert list(gen()) == [0, 0, 1, -1, 2, -2]
+
+# invalid except clauses propagate
+try:
+    try:
+        raise KeyError
+    except 1:
+        exit(1)
+    exit(1)
+except TypeError:
+    pass
@@ -0,0 +1,94 @@
+# exhausted iterators in for loops
+class Counter:
+    def __init__(self, n):
+        self.i = 0
+        self.n = n
+    def __iter__(self):
+        return self
+    def __next__(self):
+        if self.i >= self.n:
+            raise StopIteration
+        self.i += 1
+        return self.i
+
+assert list(Counter(3)) == [1, 2, 3]
+assert sum(Counter(100)) == 5050
+total = 0
+for i in range(10):
+    for x in Counter(i):
+        total += x
+assert total == 165
+
+# next() on an exhausted iterator can be caught
+it = iter([1])
+assert next(it) == 1
+try:
+    next(it)
+    exit(1)
+except StopIteration as e:
+    assert type(e) is StopIteration
+    assert e.value is None
+
+try:
+    next(Counter(0))
+    exit(1)
+except StopIteration:
+    pass
+
+# the same with an explicit value
+class Last:
+    def __next__(self):
+        raise StopIteration(42)
+
+try:
+    next(Last())
+    exit(1)
+except StopIteration as e:
+    assert e.value == 42
+
+# a finished generator returns its value to `yield from`
+def gen(n):
+    yield from range(n)
+    return n * 2
+
+def outer():
+    r = yield from gen(3)
+    yield r
+    r = yield from iter([])
+    yield r
+
+assert list(outer()) == [0, 1, 2, 6, None]
+
+g = gen(1)
+next(g)
+try:
+    next(g)
+    exit(1)
+except StopIteration as e:
+    assert e.value == 2
+
+# exhausted generators keep raising
+try:
+    next(g)
+    exit(1)
+except StopIteration as e:
+    assert e.value is None
+
+# an uncaught exhaustion is reported with a traceback
+import traceback
+
+def f():
+    next(iter(()))
+
+try:
+    f()
+    exit(1)
+except StopIteration:
+    assert 'StopIteration' in traceback.format_exc()
+
+# module level code is not an iterator, its frame stays in the traceback
+try:
+    exec('x = 1\nnext(iter([]))', {})
+    exit(1)
+except StopIteration:
+    assert 'line 2' in traceback.format_exc(), traceback.format_exc()
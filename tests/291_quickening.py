@@ -0,0 +1,147 @@
+# every site below runs more than enough times to be quickened
+
+# FOR_ITER over different iterables at the same site
+def total(it):
+    s = 0
+    for x in it:
+        s += x
+    return s
+
+for _ in range(20):
+    assert total([1, 2, 3]) == 6
+assert total((1, 2, 3)) == 6
+assert total(range(4)) == 6
+assert total(range(10, 0, -3)) == 22
+assert total(range(0)) == 0
+assert total({1: 0, 2: 0}) == 3
+
+def gen():
+    yield 4
+    yield 5
+
+assert total(gen()) == 9
+assert total([1, 2, 3]) == 6
+
+# list mutation during iteration
+a = [1, 2, 3]
+res = []
+for x in a:
+    res.append(x)
+    if len(a) < 6:
+        a.append(x * 10)
+assert res == [1, 2, 3, 10, 20, 30]
+
+# iterator resumed after break
+it = iter(range(10))
+for x in it:
+    if x == 3:
+        break
+assert next(it) == 4
+assert list(it) == [5, 6, 7, 8, 9]
+
+# LOAD_SUBSCR on list[int]
+def getitem(a, i):
+    return a[i]
+
+for i in range(20):
+    assert getitem([1, 2, 3], i % 3) == i % 3 + 1
+assert getitem([1, 2, 3], -1) == 3
+assert getitem((1, 2, 3), 0) == 1
+assert getitem({'a': 1}, 'a') == 1
+assert getitem([1, 2, 3], slice(1, None, None)) == [2, 3]
+assert getitem('abc', 1) == 'b'
+for i in range(20):
+    assert getitem([1, 2, 3], 0) == 1
+try:
+    getitem([1, 2, 3], 3)
+    exit(1)
+except IndexError:
+    pass
+
+class MyList:
+    def __getitem__(self, i):
+        return 'custom'
+
+assert getitem(MyList(), 0) == 'custom'
+
+# CALL of simple python functions
+def add(a, b):
+    return a + b
+
+def call2(f, a, b):
+    return f(a, b)
+
+for i in range(20):
+    assert call2(add, i, 1) == i + 1
+assert call2(lambda a, b=5: a * b, 2, 3) == 6
+assert call2(max, 2, 3) == 3
+assert call2(lambda *args: len(args), 1, 2) == 2
+for i in range(20):
+    assert call2(add, i, 1) == i + 1
+try:
+    call2(lambda a: a, 1, 2)
+    exit(1)
+except TypeError:
+    pass
+
+class A:
+    def f(self, x):
+        return x + 1
+
+a = A()
+for i in range(20):
+    assert a.f(i) == i + 1
+
+# CALL of python functions with keyword parameters
+def spawn(x, y=0, team='red', hp=100):
+    return (x, y, team, hp)
+
+def spawn2(x, y=1, team='blue', hp=50):
+    return (x, y, team, hp)
+
+def call_kw(f, x):
+    return f(x, team='green', y=2)
+
+def call_default(f, x):
+    return f(x)
+
+for i in range(20):
+    assert call_kw(spawn, i) == (i, 2, 'green', 100)
+    assert call_default(spawn, i) == (i, 0, 'red', 100)
+assert call_kw(spawn2, 1) == (1, 2, 'green', 50)
+assert call_default(spawn2, 1) == (1, 1, 'blue', 50)
+assert call_kw(lambda x, **kw: kw, 1) == {'team': 'green', 'y': 2}
+try:
+    call_kw(lambda x, y=0: x, 1)
+    exit(1)
+except TypeError:
+    pass
+for i in range(20):
+    assert call_kw(spawn2, i) == (i, 2, 'green', 50)
+
+for i in range(20):
+    assert spawn(i, hp=i) == (i, 0, 'red', i)
+
+class Unit:
+    def move(self, dx=0, dy=0):
+        return (dx, dy)
+
+u = Unit()
+for i in range(20):
+    assert u.move(dy=i) == (0, i)
+    assert Unit.move(u, dx=i) == (i, 0)
+
+# recursion through a quickened call
+def fib(n):
+    if n < 2:
+        return n
+    return fib(n - 1) + fib(n - 2)
+
+assert fib(15) == 610
+
+# quickened code must disassemble and serialize as the generic form
+import dis
+dis.dis(total)
+dis.dis(getitem)
+dis.dis(call2)
+dis.dis(call_kw)
@@ -0,0 +1,104 @@
+# LOAD_FAST LOAD_FAST
+def add(a, b):
+    return a + b
+
+assert add(1, 2) == 3
+
+def unbound_second(a):
+    if a:
+        b = 1
+    return a + b
+
+assert unbound_second(1) == 2
+try:
+    unbound_second(0)
+    exit(1)
+except UnboundLocalError:
+    pass
+
+def unbound_first(a):
+    if a:
+        b = 1
+    return b + a
+
+try:
+    unbound_first(0)
+    exit(1)
+except UnboundLocalError:
+    pass
+
+# LOAD_FAST LOAD_CONST
+def inc(a):
+    return a + 1
+
+assert inc(1) == 2
+
+# LOAD_FAST LOAD_ATTR
+class A:
+    def __init__(self):
+        self.x = 1
+
+def get_x(a):
+    return a.x
+
+assert get_x(A()) == 1
+try:
+    get_x(1)
+    exit(1)
+except AttributeError:
+    pass
+
+# COMPARE_xx POP_JUMP_IF_FALSE
+def cmp(a, b):
+    res = []
+    if a < b: res.append('<')
+    if a <= b: res.append('<=')
+    if a == b: res.append('==')
+    if a != b: res.append('!=')
+    if a > b: res.append('>')
+    if a >= b: res.append('>=')
+    return res
+
+assert cmp(1, 2) == ['<', '<=', '!=']
+assert cmp(2, 2) == ['<=', '==', '>=']
+assert cmp(2.5, 2) == ['!=', '>', '>=']
+assert cmp('a', 'b') == ['<', '<=', '!=']
+
+class B:
+    def __init__(self, v):
+        self.v = v
+    def __lt__(self, other):
+        return self.v < other.v
+    def __eq__(self, other):
+        return [] if self.v != other.v else [1]
+    def __ne__(self, other):
+        return not self.__eq__(other)
+
+i = 0
+while B(i) < B(3):
+    i += 1
+assert i == 3
+if B(1) == B(2):
+    exit(1)
+try:
+    if B(1) > 1:
+        pass
+    exit(1)
+except TypeError:
+    pass
+
+# loops jumping to the fused instruction
+def count(n):
+    i = 0
+    while i < n:
+        i += 1
+    return i
+
+assert count(5) == 5
+
+# the second instruction still reports its own line
+def multiline(a, b):
+    return (a +
+            b)
+
+assert multiline(1, 2) == 3
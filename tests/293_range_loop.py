@@ -0,0 +1,93 @@
+# counted loops over range(...)
+def collect(*args):
+    return [i for i in range(*args)]
+
+def loop(*args):
+    res = []
+    if len(args) == 1:
+        for i in range(args[0]):
+            res.append(i)
+    elif len(args) == 2:
+        for i in range(args[0], args[1]):
+            res.append(i)
+    else:
+        for i in range(args[0], args[1], args[2]):
+            res.append(i)
+    return res
+
+cases = [(0,), (5,), (-3,), (2, 7), (7, 2), (-5, 5), (0, 10, 3), (10, 0, -3), (10, -10, -7),
+         (0, 1, 2**40), (5, 0, -2**40), (2**62, 2**62 + 3)]
+for args in cases:
+    assert loop(*args) == collect(*args) == list(range(*args)), args
+
+# nested loops, break, continue and else
+total = 0
+for i in range(10):
+    for j in range(i, 10, 2):
+        if j == 7:
+            continue
+        if j > 8:
+            break
+        total += j
+assert total == 102
+
+for i in range(3):
+    pass
+else:
+    assert i == 2
+
+for i in range(3):
+    if i == 1:
+        break
+else:
+    exit(1)
+
+# exceptions inside the loop body
+caught = 0
+for i in range(5):
+    try:
+        if i % 2:
+            raise ValueError(i)
+    except ValueError:
+        caught += 1
+assert caught == 2
+
+# generators suspended in a counted loop
+def gen(n):
+    for i in range(n):
+        yield i * i
+
+assert list(gen(5)) == [0, 1, 4, 9, 16]
+assert sum([x for x in range(100)]) == 4950
+
+# invalid arguments
+try:
+    for i in range(1.5):
+        pass
+    exit(1)
+except TypeError:
+    pass
+
+try:
+    for i in range(0, 10, 0):
+        pass
+    exit(1)
+except ValueError:
+    pass
+
+# a rebound `range` is called as usual
+def with_local_range():
+    range = lambda n: ['a'] * n
+    return [x for x in range(2)]
+
+assert with_local_range() == ['a', 'a']
+
+_range = range
+range = lambda *args: 'xyz'
+assert [c for c in range(100)] == ['x', 'y', 'z']
+res = []
+for c in range(1):
+    res.append(c)
+assert res == ['x', 'y', 'z']
+range = _range
+assert loop(3) == [0, 1, 2]
@@ -25,6 +25,10 @@ assert MyClass.get_xy() == (1, 0)
 inst = MyClass()
 assert inst.some_func() == '123'
 
+get_g_value = a.get_g_value
+for _ in range(3):
+    assert get_g_value() == '123'
+
 # reload
 os.environ['TEST_RELOAD_VALUE'] = '456'
 os.environ['SET_X'] = '0'
@@ -39,5 +43,5 @@ assert id(MyClass.get_xy) != getxyid
 assert MyClass.value == '456'
 assert inst.some_func() == '456'
 assert (MyClass.get_xy() == (1, 1)), MyClass.get_xy()
-
-
+assert get_g_value() == '456'
+assert a.get_g_value() == '456'
@@ -0,0 +1,133 @@
+class A:
+    x = 1
+
+    def f(self):
+        return 'A.f'
+
+    @property
+    def p(self):
+        return 'A.p'
+
+class B(A):
+    pass
+
+def get_x(obj):
+    return obj.x
+
+def call_f(obj):
+    return obj.f()
+
+def get_p(obj):
+    return obj.p
+
+def set_y(obj, val):
+    obj.y = val
+
+a = A()
+b = B()
+
+# class attribute, shadowed by instance attribute
+for _ in range(3):
+    assert get_x(a) == 1
+    assert get_x(b) == 1
+b.x = 2
+assert get_x(b) == 2
+assert get_x(a) == 1
+del b.x
+assert get_x(b) == 1
+
+# modifying a base class invalidates subclasses
+A.x = 3
+assert get_x(a) == 3
+assert get_x(b) == 3
+B.x = 4
+assert get_x(a) == 3
+assert get_x(b) == 4
+del B.x
+assert get_x(b) == 3
+
+# method rebinding
+for _ in range(3):
+    assert call_f(a) == 'A.f'
+    assert call_f(b) == 'A.f'
+B.f = lambda self: 'B.f'
+assert call_f(a) == 'A.f'
+assert call_f(b) == 'B.f'
+A.f = lambda self: 'A.f2'
+assert call_f(a) == 'A.f2'
+assert call_f(b) == 'B.f'
+del B.f
+assert call_f(b) == 'A.f2'
+
+# bound method through attribute load
+for _ in range(3):
+    m = a.f
+    assert m() == 'A.f2'
+
+# property is a data descriptor
+for _ in range(3):
+    assert get_p(a) == 'A.p'
+a.__dict__['p'] = 'instance'
+assert get_p(a) == 'A.p'
+A.p = property(lambda self: 'A.p2')
+assert get_p(a) == 'A.p2'
+A.p = 5
+assert get_p(a) == 'instance'
+assert get_p(b) == 5
+
+# store then load through the same sites
+for i in range(3):
+    set_y(a, i)
+    assert a.y == i
+
+class C:
+    def __init__(self):
+        self._v = 0
+
+    @property
+    def v(self):
+        return self._v
+
+    @v.setter
+    def v(self, val):
+        self._v = val * 2
+
+c = C()
+for i in range(3):
+    c.v = i
+    assert c.v == i * 2
+
+# readonly property after cached store
+A.p = property(lambda self: 'A.p3')
+try:
+    set_y(a, 1)
+    a.p = 1
+    exit(1)
+except TypeError:
+    pass
+
+# polymorphic call site
+class D:
+    def f(self):
+        return 'D.f'
+
+for obj in [a, D(), b, D(), a]:
+    assert call_f(obj) in ('A.f2', 'D.f')
+assert call_f(D()) == 'D.f'
+
+# module attributes
+import math
+for _ in range(3):
+    assert math.pi > 3
+    assert math.floor(1.5) == 1
+
+# missing attributes still go through __getattr__
+class E:
+    def __getattr__(self, name):
+        return name
+
+e = E()
+for _ in range(3):
+    assert e.foo == 'foo'
+e.foo = 1
+assert e.foo == 1
@@ -0,0 +1,109 @@
+class Vec:
+    def __init__(self, x, y=0):
+        self.x = x
+        self.y = y
+
+def make(x, y):
+    return Vec(x, y=y)
+
+# constructors used inside expressions keep the stack intact
+for i in range(10):
+    v = make(i, 2)
+    assert (v.x, v.y) == (i, 2)
+    a = [Vec(i), Vec(i + 1), Vec(i + 2)]
+    assert [v.x for v in a] == [i, i + 1, i + 2]
+    assert max(Vec(i).x, Vec(i, 5).y) == max(i, 5)
+
+# __init__ can reassign self
+class Weird:
+    def __init__(self):
+        self = None
+
+assert type(Weird()) is Weird
+
+# rebinding __init__ invalidates the cached constructor
+for _ in range(3):
+    assert Vec(1).y == 0
+Vec.__init__ = lambda self, x: setattr(self, 'x', x * 2)
+assert Vec(1).x == 2
+try:
+    Vec(1, 2)
+    exit(1)
+except TypeError:
+    pass
+
+# inherited __init__, then overridden in the base
+class Base:
+    def __init__(self, v):
+        self.v = v
+
+class Derived(Base):
+    pass
+
+for i in range(3):
+    assert Derived(i).v == i
+Base.__init__ = lambda self, v: setattr(self, 'v', -v)
+assert Derived(1).v == -1
+
+# super().__init__ from a python __init__
+class Derived2(Base):
+    def __init__(self, v):
+        super().__init__(v)
+        self.w = v + 1
+
+for i in range(3):
+    d = Derived2(i)
+    assert (d.v, d.w) == (-i, i + 1)
+
+# a custom __new__ added later disables the fast path
+class Counted:
+    def __init__(self):
+        self.ok = True
+
+for _ in range(3):
+    assert Counted().ok
+calls = []
+def counted_new(cls):
+    calls.append(cls)
+    return object.__new__(cls)
+Counted.__new__ = counted_new
+assert Counted().ok
+assert calls == [Counted]
+
+# exceptions raised by __init__
+class Bad:
+    def __init__(self, x):
+        if x < 0:
+            raise ValueError(x)
+        self.x = x
+
+for i in range(5):
+    try:
+        Bad(-i - 1)
+        exit(1)
+    except ValueError:
+        pass
+    assert Bad(i).x == i
+
+# recursive construction
+class Node:
+    def __init__(self, depth):
+        self.child = Node(depth - 1) if depth > 0 else None
+
+n = Node(50)
+depth = 0
+while n.child is not None:
+    n = n.child
+    depth += 1
+assert depth == 50
+
+# no __init__ at all
+class Empty:
+    pass
+
+assert type(Empty()) is Empty
+try:
+    Empty(1)
+    exit(1)
+except TypeError:
+    pass
@@ -0,0 +1,88 @@
+class P:
+    def __init__(self, x, y):
+        self.x = x
+        self.y = y
+
+def get_x(p):
+    return p.x
+
+def set_z(p, z):
+    p.z = z
+
+# instances share a shape, the same sites see other shapes too
+ps = [P(i, -i) for i in range(10)]
+for p in ps:
+    assert get_x(p) == p.y * -1
+q = P(0, 0)
+q.w = 1
+for i in range(5):
+    set_z(ps[i], i)
+    set_z(q, i)
+    assert get_x(q) == 0 and q.z == i
+assert [p.z for p in ps[:5]] == [0, 1, 2, 3, 4]
+for p in ps[5:]:
+    assert not hasattr(p, 'z')
+    set_z(p, 10)
+assert ps[9].z == 10
+
+# different orders of the same keys
+class Q:
+    pass
+
+a = Q(); a.x = 1; a.y = 2
+b = Q(); b.y = 3; b.x = 4
+for _ in range(3):
+    assert (get_x(a), get_x(b)) == (1, 4)
+assert dict(a.__dict__.items()) == {'x': 1, 'y': 2}
+assert dict(b.__dict__.items()) == {'y': 3, 'x': 4}
+
+# deleting an attribute falls back to a hash table
+del a.x
+assert not hasattr(a, 'x')
+try:
+    get_x(a)
+    exit(1)
+except AttributeError:
+    pass
+a.x = 5
+assert get_x(a) == 5 and a.y == 2
+
+# many attributes fall back to a hash table
+big = Q()
+for i in range(100):
+    setattr(big, 'attr_%d' % i, i)
+for i in range(100):
+    assert getattr(big, 'attr_%d' % i) == i
+assert len(big.__dict__.items()) == 100
+
+# many different shapes of one type
+objs = []
+for i in range(2000):
+    o = Q()
+    setattr(o, 'key_%d' % i, i)
+    o.x = i
+    objs.append(o)
+for i, o in enumerate(objs):
+    assert getattr(o, 'key_%d' % i) == i
+    assert get_x(o) == i
+
+# __dict__ views and clearing
+p = P(1, 2)
+assert list(p.__dict__.items()) == [('x', 1), ('y', 2)]
+p.__dict__.clear()
+assert not hasattr(p, 'x')
+p.y = 3
+assert dict(p.__dict__.items()) == {'y': 3}
+
+# reassigning the same attribute keeps values in place
+p = P(1, 2)
+for i in range(10):
+    p.x = i
+    p.y = i * 2
+assert (p.x, p.y) == (9, 18)
+
+import pickle
+p = P(1, [2, 3])
+p.z = 'z'
+p2 = pickle.loads(pickle.dumps(p))
+assert (p2.x, p2.y, p2.z) == (1, [2, 3], 'z')
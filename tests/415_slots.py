@@ -0,0 +1,97 @@
+class Point:
+    __slots__ = ('x', 'y')
+
+    def __init__(self, x, y):
+        self.x = x
+        self.y = y
+
+    def norm2(self):
+        return self.x * self.x + self.y * self.y
+
+p = Point(3, 4)
+assert p.norm2() == 25
+p.x = 5
+assert (p.x, p.y) == (5, 4)
+
+# no instance __dict__
+try:
+    p.z = 1
+    exit(1)
+except AttributeError:
+    pass
+
+# unset and deleted members
+class Lazy:
+    __slots__ = 'value'
+
+a = Lazy()
+assert not hasattr(a, 'value')
+a.value = 1
+assert a.value == 1
+del a.value
+try:
+    a.value
+    exit(1)
+except AttributeError:
+    pass
+try:
+    del a.value
+    exit(1)
+except AttributeError:
+    pass
+
+# cached sites
+def get_x(p):
+    return p.x
+
+def set_x(p, x):
+    p.x = x
+
+for i in range(10):
+    q = Point(i, -i)
+    set_x(q, i * 2)
+    assert get_x(q) == i * 2 and q.y == -i
+
+# members are class attributes
+assert 'x' in Point.__dict__
+assert isinstance(Point.__dict__['x'], type(Point.y))
+
+# subclasses extend the layout
+class Point3(Point):
+    __slots__ = ['z']
+
+    def __init__(self, x, y, z):
+        super().__init__(x, y)
+        self.z = z
+
+p3 = Point3(1, 2, 3)
+assert (p3.x, p3.y, p3.z) == (1, 2, 3)
+assert get_x(p3) == 1
+assert p3.norm2() == 5
+
+# conflicts with class variables
+try:
+    class Bad:
+        __slots__ = ('x',)
+        x = 1
+    exit(1)
+except ValueError:
+    pass
+
+# `__dict__` in `__slots__` keeps the instance dict
+class Open:
+    __slots__ = ('a', '__dict__')
+
+o = Open()
+o.a = 1
+o.b = 2
+assert (o.a, o.b) == (1, 2)
+
+import pickle
+p = Point(1, [2, 3])
+p2 = pickle.loads(pickle.dumps(p))
+assert (p2.x, p2.y) == (1, [2, 3])
+p3 = pickle.loads(pickle.dumps(Point3(1, 2, 3)))
+assert (p3.x, p3.y, p3.z) == (1, 2, 3)
+a = pickle.loads(pickle.dumps(Lazy()))
+assert not hasattr(a, 'value')
@@ -1,4 +1,4 @@
-# only one level nested closure is implemented
+# closures capture values of the enclosing function when they are created
 
 def f0(a, b):
     def f1():
@@ -61,3 +61,52 @@ try:
     assert False
 except StopIteration as e:
     assert e.value == 3
+
+# multi-level closure
+def outer(a):
+    b = 2
+    def middle():
+        def inner():
+            return a + b
+        return inner
+    return middle
+
+assert outer(1)()() == 3
+
+# names not bound in the enclosing function are globals or builtins
+g_value = 10
+def f0():
+    def f1():
+        return g_value + len([1])
+    return f1
+
+assert f0()() == 11
+g_value = 20
+assert f0()() == 21
+
+# captured mutable objects are shared
+def counter():
+    box = [0]
+    def inc():
+        box[0] += 1
+        return box[0]
+    return inc
+
+c = counter()
+assert c() == 1
+assert c() == 2
+
+# closures created in a loop
+def make_adders():
+    res = []
+    offset = 100
+    for i in range(3):
+        def add(x):
+            return x + offset
+        res.append(add)
+    return res
+
+adders = make_adders()
+assert len(adders) == 3
+assert adders[0](1) == 101
+assert adders[2](2) == 102
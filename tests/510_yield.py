@@ -127,4 +127,21 @@ def f():
     a = yield from g()
     yield a
 
-assert list(f()) == [1, 2, 3]
\ No newline at end of file
+assert list(f()) == [1, 2, 3]
+# suspended frames keep their values alive, with a varying stack depth
+import gc
+
+def h(n):
+    data = [str(i) for i in range(n)]
+    for x in data:
+        for y in [x, x + x]:
+            yield y
+    yield (data, [d for d in data])
+
+it = h(3)
+res = []
+for v in it:
+    gc.collect()
+    res.append(v)
+assert res[:6] == ['0', '00', '1', '11', '2', '22']
+assert res[6] == (['0', '1', '2'], ['0', '1', '2'])
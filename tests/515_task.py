@@ -0,0 +1,155 @@
+from pkpy import Task
+
+# run in slices
+src = '''
+def fib(n):
+    if n < 2:
+        return n
+    return fib(n - 1) + fib(n - 2)
+
+out = []
+for i in range(10):
+    out.append(fib(i))
+'''
+
+t = Task(src)
+assert not t.is_done
+slices = 1
+while not t.run(50):
+    slices += 1
+assert t.is_done
+assert slices > 10
+assert out == [0, 1, 1, 2, 3, 5, 8, 13, 21, 34]
+
+try:
+    t.run(10)
+    exit(1)
+except RuntimeError:
+    pass
+
+# a large budget finishes at once
+t = Task('x = [i * 2 for i in range(5)]')
+assert t.run(100000)
+assert x == [0, 2, 4, 6, 8]
+
+# zero budget makes no progress
+t = Task('y = 1')
+assert not t.run(0)
+assert not t.run(0)
+assert t.run(100)
+assert y == 1
+
+# eval mode
+t = Task('sum(range(10))', 'eval')
+assert t.run(1000)
+
+# suspended inside loops, calls and try blocks
+src = '''
+def gen(n):
+    for i in range(n):
+        yield i
+
+def g(a, b):
+    s = []
+    try:
+        for x in gen(a):
+            s.append(x + b)
+        raise ValueError(len(s))
+    except ValueError as e:
+        s.append(e.args[0])
+    return s
+
+res = g(5, 10)
+'''
+t = Task(src)
+while not t.run(1):
+    pass
+assert res == [10, 11, 12, 13, 14, 5]
+
+# exceptions propagate out of `run`
+t = Task('''
+def f():
+    for i in range(100):
+        pass
+    raise KeyError(1)
+f()
+''')
+try:
+    while not t.run(7):
+        pass
+    exit(1)
+except KeyError:
+    pass
+assert t.is_done
+
+# interleaved tasks
+log = []
+a = Task('for i in range(3): log.append("a")')
+b = Task('for i in range(3): log.append("b")')
+while not (a.is_done and b.is_done):
+    if not a.is_done: a.run(4)
+    if not b.is_done: b.run(4)
+assert log.count('a') == 3 and log.count('b') == 3
+assert log != ['a', 'a', 'a', 'b', 'b', 'b']
+
+# class bodies
+t = Task('''
+class A:
+    x = 1
+    y = x + 1
+    def f(self): return self.y
+z = A().f()
+''')
+while not t.run(1):
+    pass
+assert z == 2
+
+# nested tasks
+inner_src = 'k = 0\nfor i in range(20): k += i'
+outer = Task('''
+from pkpy import Task
+inner = Task(inner_src)
+n = 0
+while not inner.run(3):
+    n += 1
+''')
+while not outer.run(5):
+    pass
+assert k == 190
+assert n > 1
+
+# values of suspended frames survive gc
+import gc
+t = Task('''
+def f():
+    a = [str(i) for i in range(3)]
+    b = {'k': a}
+    for i in range(50):
+        pass
+    return b
+r = f()
+''')
+while not t.run(5):
+    gc.collect()
+assert r == {'k': ['0', '1', '2']}
+
+# a task cannot run itself
+for started in [False, True]:
+    t = Task('''
+try:
+    t.run(100)
+    err = None
+except RuntimeError as e:
+    err = e
+''')
+    if started:
+        assert not t.run(1)
+    assert t.run(100000)
+    assert type(err) is RuntimeError, err
+    assert t.is_done
+
+# dropping a suspended task
+t = Task('while True: pass')
+assert not t.run(100)
+del t
+gc.collect()
@@ -0,0 +1,87 @@
+import gc
+
+class Node:
+    def __init__(self, value):
+        self.value = value
+        self.next = None
+
+class Point:
+    __slots__ = ['x', 'y']
+
+def make_garbage(n):
+    for i in range(n):
+        [i, str(i), Node(i)]
+
+# long-lived objects become old after a full collection
+old_list = []
+old_dict = {}
+old_node = Node(-1)
+old_point = Point()
+gc.collect()
+
+# young objects stored into old ones survive young collections
+for i in range(100):
+    old_list.append(Node(i))
+    old_dict[i] = [str(i)]
+    old_node.next = Node(i)
+    old_point.x = (i, str(i))
+    make_garbage(20)
+    gc.collect(0)
+
+assert [n.value for n in old_list] == list(range(100))
+for i in range(100):
+    assert old_dict[i] == [str(i)]
+assert old_node.next.value == 99
+assert old_point.x == (99, '99')
+
+# the same objects are old now, mutate them again
+gc.collect()
+for i in range(100):
+    old_list[i] = Node(-i)
+    old_list[i].next = [Node(i)]
+    make_garbage(20)
+gc.collect(0)
+gc.collect()
+assert [n.value for n in old_list] == [-i for i in range(100)]
+assert [n.next[0].value for n in old_list] == list(range(100))
+
+# collections while a C function is calling into python
+holder = []
+gc.collect()
+
+def produce(container):
+    for i in range(50):
+        container.append([Node(i)])
+        make_garbage(20)
+        gc.collect(0)
+        yield i
+
+for i in produce(holder):
+    make_garbage(10)
+assert [x[0].value for x in holder] == list(range(50))
+
+def key(x):
+    make_garbage(10)
+    gc.collect(0)
+    old_dict[x] = Node(x)
+    return -x
+
+assert sorted(range(20), key=key) == list(range(19, -1, -1))
+gc.collect(0)
+assert [old_dict[i].value for i in range(20)] == list(range(20))
+
+# frame-driven usage
+gc.disable()
+frames = []
+for frame in range(200):
+    tmp = [Node(i) for i in range(20)]
+    frames.append(tmp[frame % 20])
+    gc.collect_hint()
+gc.enable()
+assert [n.value for n in frames] == [i % 20 for i in range(200)]
+
+try:
+    gc.collect(3)
+    exit(1)
+except ValueError:
+    pass
@@ -0,0 +1,78 @@
+import gc
+import time
+
+class Node:
+    def __init__(self, value):
+        self.value = value
+        self.children = [str(value)]
+
+def make_garbage(n):
+    for i in range(n):
+        Node(i)
+
+def run_cycle(budget_us, mutate=None):
+    steps = []
+    while True:
+        t0 = time.perf_counter()
+        done = gc.step(budget_us)
+        steps.append(time.perf_counter() - t0)
+        if mutate is not None:
+            mutate(len(steps))
+        if done:
+            return steps
+        assert len(steps) < 100000
+
+gc.disable()
+
+# a large heap without huge containers, they are traced at once
+heap = [[Node(i * 100 + j) for j in range(100)] for i in range(2000)]
+t0 = time.perf_counter()
+gc.collect()
+full = time.perf_counter() - t0
+
+# enough allocations to start a cycle
+make_garbage(200000)
+budget = max(full / 10, 0.0005)
+steps = run_cycle(int(budget * 1e6))
+assert len(steps) >= 3, steps
+assert max(steps) < full / 2 + budget, (full, max(steps))
+
+# nothing is started without allocations
+assert gc.step(1000) == False
+
+# mutate the heap between steps
+moved = []
+def mutate(i):
+    group = heap[i % len(heap)]
+    moved.append(group.pop())
+    group.append(Node(-i))
+    heap[(i * 7) % len(heap)][0].children.append(Node(i))
+    make_garbage(50)
+
+make_garbage(200000)
+run_cycle(100, mutate)
+make_garbage(200000)
+run_cycle(100, mutate)
+for group in heap:
+    assert len(group) == 100
+    for node in group:
+        assert type(node.value) is int
+        assert node.children[0] == str(node.value)
+        for child in node.children[1:]:
+            assert child.children == [str(child.value)]
+for node in moved:
+    assert node.children == [str(node.value)]
+
+# other collections complete the cycle in progress
+make_garbage(200000)
+gc.step(1)
+assert gc.collect() > 0
+assert gc.step(1000) == False
+
+gc.enable()
+
+try:
+    gc.step(-1)
+    exit(1)
+except ValueError:
+    pass
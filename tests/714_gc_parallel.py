@@ -0,0 +1,57 @@
+import gc
+
+class Node:
+    def __init__(self, value):
+        self.value = value
+        self.children = [str(value)]
+
+class Point:
+    __slots__ = ['x', 'y']
+
+def make_garbage(n):
+    for i in range(n):
+        [Node(i), {i: str(i)}, (i, i)]
+
+gc.set_threads(4)
+
+# a heap large enough for the workers, with a long chain and wide containers
+head = None
+for i in range(20000):
+    node = Node(i)
+    node.children.append(head)
+    head = node
+groups = [[Node(i * 100 + j) for j in range(100)] for i in range(500)]
+table = {i: Point() for i in range(20000)}
+for i, p in table.items():
+    p.x = str(i)
+    p.y = [i]
+
+for _ in range(3):
+    make_garbage(50000)
+    assert gc.collect() > 0
+
+node = head
+for i in range(19999, -1, -1):
+    assert node.value == i
+    assert node.children[0] == str(i)
+    node = node.children[1]
+assert node is None
+for i, group in enumerate(groups):
+    assert [n.value for n in group] == list(range(i * 100, i * 100 + 100))
+for i, p in table.items():
+    assert p.x == str(i) and p.y == [i]
+
+# objects of user types are freed as well
+gc.collect()
+del head, groups
+assert gc.collect() >= 20000 + 50000
+
+gc.set_threads(1)
+make_garbage(1000)
+assert gc.collect() > 0
+
+try:
+    gc.set_threads(0)
+    exit(1)
+except ValueError:
+    pass
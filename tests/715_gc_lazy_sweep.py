@@ -0,0 +1,52 @@
+import gc
+
+class Node:
+    def __init__(self, value):
+        self.value = value
+        self.children = [str(value)]
+
+def make_garbage(n):
+    for i in range(n):
+        Node(i)
+
+gc.disable()
+gc.collect()
+
+# automatic full collections leave the arenas to the allocator
+keep = []
+
+def grow(i):
+    keep.append([Node(i * 100 + j) for j in range(100)])
+    make_garbage(2000)
+    gc.collect_hint()
+    # written before or after their arenas are swept
+    keep[i // 2][i % 100].children.append(Node(-i))
+    make_garbage(500)
+
+finished = 0
+for i in range(300):
+    grow(i)
+    finished += gc.finish_sweep()
+assert finished > 0, finished
+assert gc.finish_sweep() == False
+
+# `gc.step()` completes the sweep as well
+for i in range(300, 1000):
+    grow(i)
+    if gc.step(1000000):
+        break
+assert i < 999
+
+for i, group in enumerate(keep):
+    for j, node in enumerate(group):
+        assert node.value == i * 100 + j
+        assert node.children[0] == str(node.value)
+        for child in node.children[1:]:
+            assert child.children == [str(child.value)]
+
+# the garbage found by an automatic collection is not reported again
+make_garbage(1000)
+assert gc.collect() >= 1000
+assert gc.collect() == 0
+
+gc.enable()
@@ -0,0 +1,37 @@
+import gc
+import pkpy
+
+# instances of 0 to 120 slots span all size classes and the large objects
+classes = []
+for n in range(0, 121, 3):
+    names = ['s' + str(i) for i in range(n)]
+    scope = {}
+    exec('class C:\n    __slots__ = ' + repr(names), scope)
+    classes.append(scope['C'])
+
+def make(i):
+    obj = classes[i % len(classes)]()
+    for name in obj.__slots__:
+        setattr(obj, name, i)
+    return obj
+
+def check(i, obj):
+    assert type(obj) is classes[i % len(classes)]
+    for name in obj.__slots__:
+        assert getattr(obj, name) == i
+
+keep = [make(i) for i in range(2000)]
+for k in range(3):
+    garbage = [make(i) for i in range(3000)]
+    strings = ['x' * (i * 37) for i in range(300)]
+    del garbage, strings
+    assert gc.collect() > 0
+    start = 2000 + k * 100
+    keep = keep[100:] + [make(i) for i in range(start, start + 100)]
+
+for i, obj in enumerate(keep):
+    check(i + 300, obj)
+
+info = pkpy.memory_usage_info()
+assert 'Pool   16:' in info or 'Pool   32:' in info, info
+assert 'allocs=' in info, info
@@ -20,4 +20,40 @@ if actual != expected:
     print(actual)
     print('--- EXPECTED RESULT ---')
     print(expected)
-    exit(1)
\ No newline at end of file
+    exit(1)
+# frames of functions that no longer exist are still formatted
+import gc
+
+def make():
+    ns = {}
+    exec('def inner():\n    raise ValueError(1)', ns)
+    return ns['inner']
+
+def keep():
+    try:
+        make()()
+    except ValueError as e:
+        return e
+
+err = keep()
+gc.collect()
+try:
+    raise err
+except ValueError:
+    actual = traceback.format_exc()
+
+expected = '''Traceback (most recent call last):
+  File "tests/802_traceback.py", line 41
+    raise err
+  File "tests/802_traceback.py", line 34, in keep
+    make()()
+  File "<string>", line 2, in inner
+    raise ValueError(1)
+ValueError: 1'''
+
+if actual != expected:
+    print('--- ACTUAL RESULT -----')
+    print(actual)
+    print('--- EXPECTED RESULT ---')
+    print(expected)
+    exit(1)
@@ -56,4 +56,30 @@ config = PrimaryForceConfig(
    planetary_humidity = 4
 )
 
-assert config.planetary_wind == 'default'
\ No newline at end of file
+assert config.planetary_wind == 'default'
+#################
+
+@dataclass(slots=True)
+class Slotted:
+    x: int
+    y: str = 'y'
+
+s = Slotted(1)
+assert (s.x, s.y) == (1, 'y')
+assert repr(Slotted(2, 'z')) == "Slotted(x=2, y='z')"
+assert asdict(s) == {'x': 1, 'y': 'y'}
+assert Slotted(1) == Slotted(1, 'y')
+assert Slotted.__slots__ == ('x', 'y')
+try:
+    s.z = 1
+    exit(1)
+except AttributeError:
+    pass
+
+@dataclass(slots=True)
+class SlottedChild(Slotted):
+    z: float = 0.5
+
+c = SlottedChild(1, 'a')
+assert (c.x, c.y, c.z) == (1, 'a', 0.5)
+assert SlottedChild.__slots__ == ('z',)
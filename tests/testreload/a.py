@@ -15,4 +15,8 @@ class MyClass:
 if os.environ['SET_X'] == '1':
     x = 1
 elif os.environ['SET_Y'] == '1':
-    y = 1
\ No newline at end of file
+    y = 1
+g_value = os.environ['TEST_RELOAD_VALUE']
+
+def get_g_value():
+    return g_value